@@ -2,9 +2,44 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <math.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include <pthread.h>
+#include <stdatomic.h>
 
 // --- Configuration & Constants ---
-#define MAX_EVENTS 20
+#define MAX_EVENTS 20   // Default buffer size (override with -n)
+#define QUEUE_SIZE 4096 // Ingestion queue slots (must be a power of two)
+#define NUM_EVENT_TYPES 4
+#define HIST_BINS 512     // Quantile sketch resolution
+#define HIST_MAX 256.0f   // Sketch covers [0, HIST_MAX); outliers go in the end bins
+#define DEFAULT_JOURNAL "meter.journal"
+#define JOURNAL_MAGIC 0x4A4D4745u // "EGMJ"
+#define JOURNAL_VERSION 1
+#define JOURNAL_SYNC_SECS 1       // Background msync interval while idle
+#define HISTORY_FACTOR 10 // Default columnar history depth, in buffers (override with -H)
+#define SCAN_SHOW 10      // Matches listed by a history scan
+#define TIER_COUNT 3      // Downsampled retention: 1 s, 1 min, 1 h buckets
+#define TREND_SHOW 60     // Buckets listed by the trend command
+#define LIVE_BUFFER_SIZE (256 * 1024) // Live output is batched here before writing
+#define LIVE_LINE_MAX 128
+#define LIVE_FLUSH_MS 100     // Longest a formatted line waits while events keep coming
+#define LIVE_SAMPLE_RATE 10   // Lines per second in sampled live mode
+
+#define LAT_BUCKETS 16384    // Benchmark latency histogram: 1 ns bins up to ~16 us
+
+// Live display modes
+#define LIVE_OFF 0
+#define LIVE_ALL 1
+#define LIVE_SAMPLED 2
 
 // --- Data Structures ---
 typedef enum {
@@ -27,15 +62,160 @@ typedef struct Node {
     struct Node* prev;
 } Node;
 
+// Growable ring of pool slots, used as a monotonic queue
+typedef struct {
+    int* slots;
+    int cap;    // Allocated entries (power of two)
+    int front;
+    int size;
+} SlotDeque;
+
+// Running statistics for one EventType over the retained window
+typedef struct {
+    int count;
+    double sum;
+    double sum_sq;
+    float min;          // Cached fronts of min_q/max_q so readers never touch the deques
+    float max;
+    SlotDeque min_q;    // Values increase front to back; front is the window minimum
+    SlotDeque max_q;    // Values decrease front to back; front is the window maximum
+    int hist[HIST_BINS]; // Fixed-bin histogram (supports removal) for quantiles
+} TypeStats;
+
+typedef struct {
+    int count;
+    float min;
+    float max;
+    double mean;
+    double stddev;
+    float p95;
+} StatsSummary;
+
+// On-disk journal layout: this header, then 'capacity' fixed-size MeterEvent records.
+// Record n lives at slot n % capacity. The two counters are the checkpoint: records
+// [max(base, committed - capacity), committed) are valid.
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t capacity;
+    _Atomic uint64_t committed; // Records ever appended; bumped after the record is written
+    _Atomic uint64_t base;      // Set to 'committed' when the log is cleared
+    char reserved[32];          // Pad the header to one cache line
+} JournalHeader;
+
 typedef struct {
+    int fd;
+    JournalHeader* header;
+    MeterEvent* records;
+    size_t map_size;
+    time_t last_sync;
+} Journal;
+
+// Columnar ring holding a much deeper history than the node buffer, at ~8 bytes
+// per event: no id (derived from position), 2-bit type, 32-bit time offset, float.
+typedef struct {
+    float* values;
+    uint32_t* time_delta; // Seconds after base_time (never decreases)
+    uint64_t* types;      // 2 bits per event, 32 events per word
+    int capacity;         // Power of two, multiple of 32 (0 = history disabled)
+    time_t base_time;
+    int base_id;          // Id of position 0
+    _Atomic uint64_t first; // Oldest retained position
+    _Atomic uint64_t total; // Next position to write
+} EventHistory;
+
+// Aggregate of every evicted event whose timestamp falls in [start, start + resolution)
+typedef struct {
+    time_t start;       // 0 = never used
+    int count[NUM_EVENT_TYPES];
+    float min[NUM_EVENT_TYPES];
+    float max[NUM_EVENT_TYPES];
+    double sum[NUM_EVENT_TYPES];
+} TimeBucket;
+
+// Fixed ring of buckets; the bucket for time t is (t / resolution) % slots
+typedef struct {
+    int resolution;     // Seconds per bucket
+    int slots;
+    time_t latest;      // Start of the newest bucket written
+    TimeBucket* buckets;
+} RetentionTier;
+
+typedef struct {
+    Node* pool;         // Preallocated nodes, reused as a ring
+    int capacity;       // Number of nodes in the pool
+    int write_slot;     // Pool slot the next event will occupy
     Node* head;         // Oldest event
     Node* tail;         // Newest event
-    Node* cursor;       // Current view position
+    _Atomic(Node*) cursor; // Current view position (moved by both threads)
     int count;
-    int live_mode;      // 1 = ON, 0 = OFF
+    atomic_int live_mode;  // LIVE_OFF, LIVE_ALL or LIVE_SAMPLED
     int next_id;        // Auto-incrementing ID
+    atomic_uint seq;    // Seqlock counter, odd while the log is being modified
+    TypeStats stats[NUM_EVENT_TYPES]; // Updated on every insert and eviction
+    Journal* journal;   // Optional persistent copy of the window (NULL = none)
+    EventHistory history; // Every event, kept longer than the node buffer
+    int cursor_adjustments; // Evictions that moved the cursor, not yet reported
+    int tiered;         // 1 = fold evicted events into the retention tiers
+    RetentionTier tiers[TIER_COUNT];
 } EventLog;
 
+// Messages from the signal source to the ingestion thread
+typedef enum {
+    MSG_EVENT,
+    MSG_CLEAR
+} MessageType;
+
+typedef struct {
+    MessageType kind;
+    MeterEvent event;
+} IngestMessage;
+
+// Single-producer/single-consumer ring; head and tail live on separate cache lines
+typedef struct {
+    IngestMessage slots[QUEUE_SIZE];
+    _Alignas(64) atomic_uint head; // Next slot to read (consumer only)
+    _Alignas(64) atomic_uint tail; // Next slot to write (producer only)
+} EventQueue;
+
+// Live display stage, owned by the ingestion thread. Lines are formatted by hand
+// into one big buffer and written in batches, and HH:MM:SS is formatted once per second.
+typedef struct {
+    char buffer[LIVE_BUFFER_SIZE];
+    size_t used;
+    time_t cached_second;
+    char cached_time[16];
+    struct timespec last_flush;
+    time_t sample_second;   // Second the sampled-mode budget applies to
+    int sampled;            // Lines shown in sample_second
+    long suppressed;        // Events skipped by sampling, not yet reported
+} LiveOutput;
+
+typedef struct {
+    EventQueue queue;
+    LiveOutput live;
+    EventLog* log;
+    pthread_t thread;
+    atomic_int running;
+    atomic_uint processed; // Messages fully applied to the log
+    unsigned int submitted; // Messages pushed by the producer
+} Ingestor;
+
+// Consistent copy of what the console needs to display
+typedef struct {
+    int count;
+    int oldest_id;
+    int newest_id;
+    int has_event;
+    MeterEvent event;
+} LogView;
+
+typedef enum {
+    SEEK_ID,
+    SEEK_TIME
+} SeekMode;
+
 // --- Helper Functions ---
 
 // Get string representation of event type
@@ -50,45 +230,389 @@ const char* get_event_type_str(EventType type) {
 }
 
 // Display a single event
-void print_event(Node* node, const char* label) {
-    if (!node) {
+void print_event(const MeterEvent* event, const char* label) {
+    if (!event) {
         printf("[%s] No event selected.\n", label);
         return;
     }
-    struct tm* tm_info = localtime(&node->data.timestamp);
+    struct tm* tm_info = localtime(&event->timestamp);
     char time_buffer[26];
     strftime(time_buffer, 26, "%H:%M:%S", tm_info);
 
-    printf("[%s] ID:%03d | Time:%s | Type:%s | Val:%.2f\n", 
-           label, node->data.id, time_buffer, 
-           get_event_type_str(node->data.type), node->data.value);
+    printf("[%s] ID:%03d | Time:%s | Type:%s | Val:%.2f\n",
+           label, event->id, time_buffer,
+           get_event_type_str(event->type), event->value);
+}
+
+// --- Seqlock ---
+// Only the ingestion thread modifies the log. Readers copy what they need and
+// retry if a write overlapped, so neither side ever blocks on a lock.
+
+void write_begin(EventLog* log) {
+    atomic_fetch_add_explicit(&log->seq, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+void write_end(EventLog* log) {
+    atomic_fetch_add_explicit(&log->seq, 1, memory_order_release);
+}
+
+unsigned int read_begin(EventLog* log) {
+    unsigned int s;
+    while ((s = atomic_load_explicit(&log->seq, memory_order_acquire)) & 1) {
+        // Writer in progress; its critical section is only a few stores
+    }
+    return s;
+}
+
+int read_retry(EventLog* log, unsigned int s) {
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&log->seq, memory_order_relaxed) != s;
+}
+
+// --- Rolling Statistics ---
+// add_event and remove_oldest keep these in step with the window, so a query
+// costs the same whether the buffer holds twenty events or twenty million.
+
+// Make room for one more entry, doubling storage when full (only until the window is warm)
+int deque_reserve(SlotDeque* q) {
+    if (q->size < q->cap) return 1;
+    int new_cap = q->cap ? q->cap * 2 : 16;
+    int* grown = (int*)malloc(sizeof(int) * (size_t)new_cap);
+    if (!grown) {
+        printf("Error: Statistics allocation failed, event dropped.\n");
+        return 0;
+    }
+    for (int i = 0; i < q->size; i++) {
+        grown[i] = q->slots[(q->front + i) & (q->cap - 1)];
+    }
+    free(q->slots);
+    q->slots = grown;
+    q->cap = new_cap;
+    q->front = 0;
+    return 1;
+}
+
+// Append to the back (deque_reserve has made room)
+void deque_push(SlotDeque* q, int slot) {
+    q->slots[(q->front + q->size) & (q->cap - 1)] = slot;
+    q->size++;
+}
+
+int deque_front(SlotDeque* q) { return q->slots[q->front]; }
+int deque_back(SlotDeque* q) { return q->slots[(q->front + q->size - 1) & (q->cap - 1)]; }
+void deque_pop_front(SlotDeque* q) { q->front = (q->front + 1) & (q->cap - 1); q->size--; }
+void deque_pop_back(SlotDeque* q) { q->size--; }
+
+int hist_bin(float value) {
+    int bin = (int)(value * (HIST_BINS / HIST_MAX));
+    if (bin < 0) return 0;
+    if (bin >= HIST_BINS) return HIST_BINS - 1;
+    return bin;
+}
+
+void reset_stats(EventLog* log) {
+    for (int t = 0; t < NUM_EVENT_TYPES; t++) {
+        TypeStats* st = &log->stats[t];
+        st->count = 0;
+        st->sum = 0.0;
+        st->sum_sq = 0.0;
+        st->min = 0.0f;
+        st->max = 0.0f;
+        st->min_q.size = 0;
+        st->max_q.size = 0;
+        memset(st->hist, 0, sizeof(st->hist));
+    }
+}
+
+// Grow the min/max queues of 'type' for one more event. add_event calls this
+// before changing anything, so stats_add itself cannot fail.
+int stats_reserve(EventLog* log, EventType type) {
+    TypeStats* st = &log->stats[type];
+    return deque_reserve(&st->min_q) && deque_reserve(&st->max_q);
+}
+
+// Account for a newly linked node (stats_reserve has made room)
+void stats_add(EventLog* log, Node* node) {
+    TypeStats* st = &log->stats[node->data.type];
+    float v = node->data.value;
+    int slot = (int)(node - log->pool);
+
+    st->count++;
+    st->sum += v;
+    st->sum_sq += (double)v * v;
+    st->hist[hist_bin(v)]++;
+
+    // Older entries that can never be the min/max again are dropped
+    while (st->min_q.size && log->pool[deque_back(&st->min_q)].data.value >= v) deque_pop_back(&st->min_q);
+    deque_push(&st->min_q, slot);
+    while (st->max_q.size && log->pool[deque_back(&st->max_q)].data.value <= v) deque_pop_back(&st->max_q);
+    deque_push(&st->max_q, slot);
+
+    st->min = log->pool[deque_front(&st->min_q)].data.value;
+    st->max = log->pool[deque_front(&st->max_q)].data.value;
+}
+
+// Account for the node being evicted (must be the oldest of its type)
+void stats_remove(EventLog* log, Node* node) {
+    TypeStats* st = &log->stats[node->data.type];
+    float v = node->data.value;
+    int slot = (int)(node - log->pool);
+
+    st->count--;
+    st->hist[hist_bin(v)]--;
+    if (st->min_q.size && deque_front(&st->min_q) == slot) deque_pop_front(&st->min_q);
+    if (st->max_q.size && deque_front(&st->max_q) == slot) deque_pop_front(&st->max_q);
+
+    if (st->count == 0) {
+        // Start from exact zero again so rounding error cannot build up
+        st->sum = 0.0;
+        st->sum_sq = 0.0;
+        return;
+    }
+    st->sum -= v;
+    st->sum_sq -= (double)v * v;
+    st->min = log->pool[deque_front(&st->min_q)].data.value;
+    st->max = log->pool[deque_front(&st->max_q)].data.value;
+}
+
+// Approximate quantile from the histogram, interpolated within the bin
+float stats_quantile(const TypeStats* st, double q) {
+    double rank = q * st->count;
+    double bin_width = HIST_MAX / HIST_BINS;
+    int seen = 0;
+    for (int b = 0; b < HIST_BINS; b++) {
+        if (st->hist[b] == 0) continue;
+        if (seen + st->hist[b] >= rank) {
+            float estimate = (float)((b + (rank - seen) / st->hist[b]) * bin_width);
+            // The exact window extremes are known, so never report past them
+            if (estimate < st->min) estimate = st->min;
+            if (estimate > st->max) estimate = st->max;
+            return estimate;
+        }
+        seen += st->hist[b];
+    }
+    return st->max;
+}
+
+void summarize_stats(const TypeStats* st, StatsSummary* out) {
+    out->count = st->count;
+    if (st->count == 0) {
+        out->min = out->max = out->p95 = 0.0f;
+        out->mean = out->stddev = 0.0;
+        return;
+    }
+    out->min = st->min;
+    out->max = st->max;
+    out->mean = st->sum / st->count;
+    double variance = st->sum_sq / st->count - out->mean * out->mean;
+    out->stddev = variance > 0.0 ? sqrt(variance) : 0.0;
+    out->p95 = stats_quantile(st, 0.95);
+}
+
+// --- Persistent Journal (hot path) ---
+// Appending is a memcpy into the shared mapping plus one counter store: no
+// syscalls. The kernel writes dirty pages back on its own; a crash of this
+// process loses nothing that was committed.
+
+void journal_append(Journal* j, const MeterEvent* event) {
+    uint64_t n = atomic_load_explicit(&j->header->committed, memory_order_relaxed);
+    j->records[n % j->header->capacity] = *event;
+    atomic_store_explicit(&j->header->committed, n + 1, memory_order_release);
+}
+
+void journal_clear(Journal* j) {
+    uint64_t n = atomic_load_explicit(&j->header->committed, memory_order_relaxed);
+    atomic_store_explicit(&j->header->base, n, memory_order_release);
+}
+
+// Schedule write-back of dirty pages (called when ingestion is idle, not per event)
+void journal_sync_if_due(Journal* j) {
+    time_t now = time(NULL);
+    if (now - j->last_sync < JOURNAL_SYNC_SECS) return;
+    msync(j->header, j->map_size, MS_ASYNC);
+    j->last_sync = now;
+}
+
+// --- Columnar History (writer side) ---
+
+int history_init(EventHistory* h, int requested) {
+    memset(h, 0, sizeof(*h));
+    if (requested <= 0) return 1;
+
+    int cap = 32;
+    while (cap < requested && cap < (1 << 30)) cap <<= 1;
+    h->values = (float*)malloc(sizeof(float) * (size_t)cap);
+    h->time_delta = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)cap);
+    h->types = (uint64_t*)calloc((size_t)cap / 32, sizeof(uint64_t));
+    if (!h->values || !h->time_delta || !h->types) {
+        printf("Error: Could not allocate history for %d events.\n", cap);
+        free(h->values);
+        free(h->time_delta);
+        free(h->types);
+        memset(h, 0, sizeof(*h));
+        return 0;
+    }
+    h->capacity = cap;
+    return 1;
+}
+
+void history_free(EventHistory* h) {
+    free(h->values);
+    free(h->time_delta);
+    free(h->types);
+    memset(h, 0, sizeof(*h));
+}
+
+void history_append(EventHistory* h, const MeterEvent* event) {
+    if (h->capacity == 0) return;
+
+    uint64_t pos = atomic_load_explicit(&h->total, memory_order_relaxed);
+    uint64_t first = atomic_load_explicit(&h->first, memory_order_relaxed);
+
+    // Ids must follow positions; anything else (e.g. a fresh anchor) restarts the history
+    if (first == pos || event->id != h->base_id + (int)pos) {
+        first = pos;
+        atomic_store_explicit(&h->first, first, memory_order_relaxed);
+        h->base_time = event->timestamp;
+        h->base_id = event->id - (int)pos;
+    }
+
+    // Publish the eviction before overwriting the slot, so scanners can detect it
+    if (pos - first >= (uint64_t)h->capacity) {
+        atomic_store_explicit(&h->first, pos + 1 - h->capacity, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+    }
+
+    int slot = (int)(pos & (uint64_t)(h->capacity - 1));
+    int prev = (int)((pos - 1) & (uint64_t)(h->capacity - 1));
+    int64_t delta = (int64_t)(event->timestamp - h->base_time);
+    if (delta < 0) delta = 0;
+    if (delta > UINT32_MAX) delta = UINT32_MAX;
+    if (pos > first && (uint32_t)delta < h->time_delta[prev]) delta = h->time_delta[prev]; // Clock stepped back
+
+    int shift = (slot & 31) * 2;
+    h->values[slot] = event->value;
+    h->time_delta[slot] = (uint32_t)delta;
+    h->types[slot >> 5] = (h->types[slot >> 5] & ~(3ull << shift)) | ((uint64_t)event->type << shift);
+    atomic_store_explicit(&h->total, pos + 1, memory_order_release);
+}
+
+void history_clear(EventHistory* h) {
+    atomic_store(&h->first, atomic_load(&h->total));
+}
+
+// --- Tiered Retention ---
+// Events leaving the node buffer are not simply dropped: each one is added to a
+// 1-second, a 1-minute and a 1-hour bucket. Old buckets are recycled in place,
+// so a week of trends costs a constant few hundred kilobytes.
+
+int init_tiers(EventLog* log) {
+    int resolutions[TIER_COUNT] = {1, 60, 3600};
+    int slots[TIER_COUNT] = {600, 1440, 168}; // 10 minutes, 1 day, 1 week
+
+    for (int i = 0; i < TIER_COUNT; i++) {
+        RetentionTier* tier = &log->tiers[i];
+        tier->resolution = resolutions[i];
+        tier->slots = slots[i];
+        tier->latest = 0;
+        tier->buckets = (TimeBucket*)calloc((size_t)slots[i], sizeof(TimeBucket));
+        if (!tier->buckets) {
+            printf("Error: Could not allocate retention tiers.\n");
+            while (i-- > 0) free(log->tiers[i].buckets);
+            return 0;
+        }
+    }
+    log->tiered = 1;
+    return 1;
+}
+
+void reset_tiers(EventLog* log) {
+    if (!log->tiered) return;
+    for (int i = 0; i < TIER_COUNT; i++) {
+        memset(log->tiers[i].buckets, 0, sizeof(TimeBucket) * (size_t)log->tiers[i].slots);
+        log->tiers[i].latest = 0;
+    }
+}
+
+void free_tiers(EventLog* log) {
+    if (!log->tiered) return;
+    for (int i = 0; i < TIER_COUNT; i++) {
+        free(log->tiers[i].buckets);
+        log->tiers[i].buckets = NULL;
+    }
+    log->tiered = 0;
+}
+
+void fold_into_tiers(EventLog* log, const MeterEvent* event) {
+    for (int i = 0; i < TIER_COUNT; i++) {
+        RetentionTier* tier = &log->tiers[i];
+        time_t start = event->timestamp - event->timestamp % tier->resolution;
+        TimeBucket* b = &tier->buckets[(event->timestamp / tier->resolution) % tier->slots];
+
+        if (b->start != start) {
+            if (b->start > start) continue; // Slot already holds a newer period
+            memset(b, 0, sizeof(*b));        // Recycle the expired bucket
+            b->start = start;
+        }
+        int t = event->type;
+        if (b->count[t] == 0 || event->value < b->min[t]) b->min[t] = event->value;
+        if (b->count[t] == 0 || event->value > b->max[t]) b->max[t] = event->value;
+        b->count[t]++;
+        b->sum[t] += event->value;
+        if (start > tier->latest) tier->latest = start;
+    }
 }
 
 // --- Core DLL Operations ---
 
 // Initialize the system
-void init_log(EventLog* log) {
+// All nodes are allocated up front in one block; add_event never allocates.
+int init_log(EventLog* log, int capacity, int history_capacity) {
+    log->pool = (Node*)malloc(sizeof(Node) * (size_t)capacity);
+    if (!log->pool) {
+        printf("Error: Could not allocate buffer for %d events.\n", capacity);
+        return 0;
+    }
+    log->capacity = capacity;
+    log->write_slot = 0;
     log->head = NULL;
     log->tail = NULL;
-    log->cursor = NULL;
+    atomic_init(&log->cursor, NULL);
     log->count = 0;
-    log->live_mode = 0;
+    atomic_init(&log->live_mode, LIVE_OFF);
     log->next_id = 101; // Starting ID
-    printf("System Initialized. Buffer size: %d\n", MAX_EVENTS);
+    atomic_init(&log->seq, 0);
+    memset(log->stats, 0, sizeof(log->stats));
+    log->journal = NULL;
+    log->cursor_adjustments = 0;
+    log->tiered = 0;
+    if (!history_init(&log->history, history_capacity)) {
+        free(log->pool);
+        return 0;
+    }
+    printf("System Initialized. Buffer size: %d\n", capacity);
+    return 1;
 }
 
 // Remove the oldest event (Head)
+// The node stays in the pool; its slot is reused once the ring wraps around.
 void remove_oldest(EventLog* log) {
     if (log->head == NULL) return;
 
     Node* temp = log->head;
-    
-    // If cursor is pointing to the node we are deleting, move it to the next one
-    if (log->cursor == temp) {
-        log->cursor = temp->next;
-        printf("<!> Oldest event removed. Cursor adjusted.\n");
+
+    // If cursor is pointing to the node we are deleting, move it to the next one.
+    // The console may be moving the cursor at the same time, so only swap if unchanged.
+    // The notice is printed by the live output stage, not here on the hot path.
+    Node* expected = temp;
+    if (atomic_compare_exchange_strong(&log->cursor, &expected, temp->next)) {
+        log->cursor_adjustments++;
     }
 
+    stats_remove(log, temp);
+    if (log->tiered) fold_into_tiers(log, &temp->data);
+
     if (log->head == log->tail) {
         // Only one item in list
         log->head = NULL;
@@ -98,28 +622,29 @@ void remove_oldest(EventLog* log) {
         log->head->prev = NULL;
     }
 
-    free(temp);
     log->count--;
 }
 
-// Add a new event to the list
-void add_event(EventLog* log, EventType type, float value) {
+// Add a new event to the list (ingestion thread only). Returns NULL, leaving
+// the log unchanged, if the statistics could not grow to take it.
+Node* add_event(EventLog* log, EventType type, float value, time_t timestamp) {
+    if (!stats_reserve(log, type)) return NULL;
+    write_begin(log);
+
     // 1. Enforce Memory Constraint
-    if (log->count >= MAX_EVENTS) {
+    if (log->count >= log->capacity) {
         remove_oldest(log);
     }
 
-    // 2. Create New Node
-    Node* new_node = (Node*)malloc(sizeof(Node));
-    if (!new_node) {
-        printf("Error: Memory allocation failed.\n");
-        return;
-    }
+    // 2. Take the next node from the ring
+    // Events are always evicted from the head, so the slot after the tail is free.
+    Node* new_node = &log->pool[log->write_slot];
+    log->write_slot = (log->write_slot + 1) % log->capacity;
 
     new_node->data.id = log->next_id++;
     new_node->data.type = type;
     new_node->data.value = value;
-    new_node->data.timestamp = time(NULL);
+    new_node->data.timestamp = timestamp;
     new_node->next = NULL;
 
     // 3. Link into List
@@ -127,110 +652,1087 @@ void add_event(EventLog* log, EventType type, float value) {
         new_node->prev = NULL;
         log->head = new_node;
         log->tail = new_node;
-        log->cursor = new_node; // Cursor always starts at oldest (head) on init
+        atomic_store(&log->cursor, new_node); // Cursor always starts at oldest (head) on init
     } else {
         new_node->prev = log->tail;
         log->tail->next = new_node;
         log->tail = new_node;
     }
 
+    stats_add(log, new_node);
     log->count++;
+    if (log->journal) journal_append(log->journal, &new_node->data);
+    history_append(&log->history, &new_node->data);
+    write_end(log);
 
-    // 4. Live Mode Handling
-    if (log->live_mode) {
-        print_event(new_node, "LIVE LOG");
-    }
+    // 4. Live display is handled by the caller (see live_output_event)
+    return new_node;
+}
+
+// The event 'offset' places after the oldest one (call inside a read section)
+Node* event_at(EventLog* log, int offset) {
+    int slot = (int)(log->head - log->pool) + offset;
+    if (slot >= log->capacity) slot -= log->capacity;
+    return &log->pool[slot];
 }
 
-// Clear all memory
+// Clear all events (the pool itself is kept for reuse)
 void clear_log(EventLog* log) {
-    Node* current = log->head;
-    while (current != NULL) {
-        Node* next = current->next;
-        free(current);
-        current = next;
-    }
+    write_begin(log);
     log->head = NULL;
     log->tail = NULL;
-    log->cursor = NULL;
+    atomic_store(&log->cursor, NULL);
     log->count = 0;
+    log->write_slot = 0;
+    reset_stats(log);
+    if (log->journal) journal_clear(log->journal);
+    history_clear(&log->history);
+    reset_tiers(log);
+    write_end(log);
     printf("Memory Cleared.\n");
 }
 
+// Release the node pool and history
+void free_log(EventLog* log) {
+    free(log->pool);
+    log->pool = NULL;
+    for (int t = 0; t < NUM_EVENT_TYPES; t++) {
+        free(log->stats[t].min_q.slots);
+        free(log->stats[t].max_q.slots);
+    }
+    memset(log->stats, 0, sizeof(log->stats));
+    history_free(&log->history);
+    free_tiers(log);
+    log->capacity = 0;
+}
+
+// --- Persistent Journal (open/recover/close) ---
+
+size_t journal_map_size(uint32_t capacity) {
+    return sizeof(JournalHeader) + sizeof(MeterEvent) * (size_t)capacity;
+}
+
+// Map 'size' bytes of the file and point the header/records at the mapping
+int journal_map(Journal* j, size_t size) {
+    void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, j->fd, 0);
+    if (base == MAP_FAILED) return 0;
+    j->header = (JournalHeader*)base;
+    j->records = (MeterEvent*)((char*)base + sizeof(JournalHeader));
+    j->map_size = size;
+    return 1;
+}
+
+// Size the file for 'capacity' records and write an empty header
+int journal_format(Journal* j, uint32_t capacity) {
+    size_t size = journal_map_size(capacity);
+    if (ftruncate(j->fd, (off_t)size) != 0 || !journal_map(j, size)) return 0;
+    j->header->magic = JOURNAL_MAGIC;
+    j->header->version = JOURNAL_VERSION;
+    j->header->record_size = sizeof(MeterEvent);
+    j->header->capacity = capacity;
+    atomic_store(&j->header->committed, 0);
+    atomic_store(&j->header->base, 0);
+    return 1;
+}
+
+// Replay the newest checkpointed records of a mapped journal into the log
+int journal_recover(Journal* j, EventLog* log) {
+    uint64_t committed = atomic_load(&j->header->committed);
+    uint64_t first = atomic_load(&j->header->base);
+    uint32_t cap = j->header->capacity;
+
+    if (committed - first > cap) first = committed - cap;
+    if (committed - first > (uint64_t)log->capacity) first = committed - log->capacity;
+
+    for (uint64_t n = first; n < committed; n++) {
+        const MeterEvent* rec = &j->records[n % cap];
+        log->next_id = rec->id; // Keep the original ids
+        add_event(log, rec->type, rec->value, rec->timestamp);
+    }
+    return (int)(committed - first);
+}
+
+// Open (or create) the journal, recover its contents into the log, and attach it.
+// A journal written with a different buffer size is rewritten at the new size;
+// one that fails validation (truncated, other version or record layout, bad
+// counters) is reformatted, so appends never land beyond the end of the file.
+int journal_open(Journal* j, const char* path, EventLog* log) {
+    struct stat st;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    j->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (j->fd < 0 || fstat(j->fd, &st) != 0) {
+        printf("Error: Could not open journal %s.\n", path);
+        if (j->fd >= 0) close(j->fd);
+        return 0;
+    }
+    j->header = NULL;
+    j->last_sync = time(NULL);
+
+    int recovered = 0;
+    if ((size_t)st.st_size >= sizeof(JournalHeader) && journal_map(j, (size_t)st.st_size)) {
+        JournalHeader* h = j->header;
+        int valid = h->magic == JOURNAL_MAGIC && h->version == JOURNAL_VERSION &&
+                    h->record_size == sizeof(MeterEvent) && h->capacity > 0 &&
+                    (size_t)st.st_size >= journal_map_size(h->capacity) &&
+                    atomic_load(&h->base) <= atomic_load(&h->committed);
+        if (valid) {
+            recovered = journal_recover(j, log);
+        } else {
+            printf("Warning: Journal %s is not valid, starting empty.\n", path);
+        }
+        if (!valid || h->capacity != (uint32_t)log->capacity) {
+            munmap(j->header, j->map_size);
+            j->header = NULL;
+        }
+    }
+
+    if (!j->header) {
+        // New file, or one laid out for another buffer size
+        if (!journal_format(j, (uint32_t)log->capacity)) {
+            printf("Error: Could not map journal %s.\n", path);
+            close(j->fd);
+            return 0;
+        }
+        for (int i = 0; i < log->count; i++) {
+            journal_append(j, &event_at(log, i)->data);
+        }
+    }
+
+    log->journal = j;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (recovered > 0) {
+        printf(">> Recovered %d events from %s in %.2f ms.\n", recovered, path,
+               (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6);
+    }
+    return 1;
+}
+
+// Flush to disk and detach the journal from the log
+void journal_close(Journal* j, EventLog* log) {
+    log->journal = NULL;
+    msync(j->header, j->map_size, MS_SYNC);
+    munmap(j->header, j->map_size);
+    close(j->fd);
+}
+
+// --- Lock-free Reads (console thread) ---
+
+// Cursor to display. If the ingestion thread evicted it between a console move
+// and the display, fall back to the oldest event. Call inside a read section.
+Node* visible_cursor(EventLog* log) {
+    Node* current = atomic_load(&log->cursor);
+    if (!current || log->count == 0) return NULL;
+    if (current->data.id < log->head->data.id) return log->head;
+    return current;
+}
+
+// Take a consistent snapshot of the count and the event under the cursor
+void read_log_view(EventLog* log, LogView* view) {
+    unsigned int s;
+    do {
+        s = read_begin(log);
+        Node* current = visible_cursor(log);
+        view->count = log->count;
+        view->oldest_id = log->count ? log->head->data.id : 0;
+        view->newest_id = log->count ? log->tail->data.id : 0;
+        view->has_event = current != NULL;
+        if (current) view->event = current->data;
+    } while (read_retry(log, s));
+}
+
+// Step the cursor one event newer (direction > 0) or older (direction < 0).
+// Returns 0 if already at the end of history in that direction.
+int move_cursor(EventLog* log, int direction) {
+    while (1) {
+        unsigned int s = read_begin(log);
+        Node* expected = atomic_load(&log->cursor);
+        Node* current = visible_cursor(log);
+        Node* target = NULL;
+        if (current) target = direction > 0 ? current->next : current->prev;
+        if (read_retry(log, s)) continue;
+
+        if (!target) return 0;
+        if (atomic_compare_exchange_strong(&log->cursor, &expected, target)) return 1;
+    }
+}
+
+// Per-type statistics for the retained window. O(HIST_BINS), independent of buffer size.
+void read_stats(EventLog* log, StatsSummary out[NUM_EVENT_TYPES]) {
+    unsigned int s;
+    do {
+        s = read_begin(log);
+        for (int t = 0; t < NUM_EVENT_TYPES; t++) {
+            summarize_stats(&log->stats[t], &out[t]);
+        }
+    } while (read_retry(log, s));
+}
+
+void print_stats(EventLog* log) {
+    StatsSummary summary[NUM_EVENT_TYPES];
+    read_stats(log, summary);
+
+    printf("\n--- Window Statistics ---\n");
+    printf("%-10s %7s %8s %8s %8s %8s %8s\n", "Type", "Count", "Min", "Max", "Mean", "StdDev", "~P95");
+    for (int t = 0; t < NUM_EVENT_TYPES; t++) {
+        if (summary[t].count == 0) {
+            printf("%-10s %7d %8s %8s %8s %8s %8s\n", get_event_type_str((EventType)t), 0, "-", "-", "-", "-", "-");
+            continue;
+        }
+        printf("%-10s %7d %8.2f %8.2f %8.2f %8.2f %8.2f\n",
+               get_event_type_str((EventType)t), summary[t].count, summary[t].min,
+               summary[t].max, summary[t].mean, summary[t].stddev, summary[t].p95);
+    }
+    printf("-------------------------\n");
+}
+
+// Copy the newest non-empty buckets of a tier (oldest first). Returns how many.
+int read_tier(EventLog* log, int tier_index, TimeBucket* out, int max_buckets) {
+    RetentionTier* tier = &log->tiers[tier_index];
+    unsigned int s;
+    int n;
+    do {
+        s = read_begin(log);
+        n = 0;
+        // Walk back from the newest period; stop at the ring size or the limit
+        for (int i = 0; i < tier->slots && n < max_buckets && tier->latest > 0; i++) {
+            time_t start = tier->latest - (time_t)i * tier->resolution;
+            TimeBucket* b = &tier->buckets[(start / tier->resolution) % tier->slots];
+            if (b->start == start) out[n++] = *b;
+        }
+    } while (read_retry(log, s));
+
+    // Reverse into chronological order
+    for (int i = 0; i < n / 2; i++) {
+        TimeBucket tmp = out[i];
+        out[i] = out[n - 1 - i];
+        out[n - 1 - i] = tmp;
+    }
+    return n;
+}
+
+void print_trend(EventLog* log, int tier_index) {
+    static TimeBucket buckets[TREND_SHOW];
+    int n = read_tier(log, tier_index, buckets, TREND_SHOW);
+    const char* fmt = log->tiers[tier_index].resolution >= 3600 ? "%m-%d %H:00" : "%m-%d %H:%M:%S";
+
+    printf("\n--- Evicted-Event Trend (%d s buckets) ---\n", log->tiers[tier_index].resolution);
+    if (n == 0) {
+        printf("No evicted events in this tier yet.\n");
+        return;
+    }
+    printf("%-15s", "Bucket");
+    for (int t = 0; t < NUM_EVENT_TYPES; t++) printf(" %22s", get_event_type_str((EventType)t));
+    printf("\n");
+
+    for (int i = 0; i < n; i++) {
+        char label[32];
+        strftime(label, sizeof(label), fmt, localtime(&buckets[i].start));
+        printf("%-15s", label);
+        for (int t = 0; t < NUM_EVENT_TYPES; t++) {
+            if (buckets[i].count[t] == 0) {
+                printf(" %22s", "-");
+            } else {
+                char cell[48];
+                snprintf(cell, sizeof(cell), "%d x %.1f [%.1f-%.1f]", buckets[i].count[t],
+                         buckets[i].sum[t] / buckets[i].count[t], buckets[i].min[t], buckets[i].max[t]);
+                printf(" %22s", cell);
+            }
+        }
+        printf("\n");
+    }
+    printf("-------------------------\n");
+}
+
+// --- Columnar History Scans (console thread) ---
+// Scans walk the columns 32 events at a time: one word of packed types and
+// eight 4-wide float compares. Nothing is locked; if the writer overwrote part
+// of the scanned range meanwhile, the scan is simply repeated.
+
+// Bit i set when event i of the word has the given type
+uint32_t type_match_bits(uint64_t word, EventType type) {
+    uint64_t x = word ^ (0x5555555555555555ull * (uint64_t)type); // Matching pairs become 00
+    x = ~(x | (x >> 1)) & 0x5555555555555555ull;
+    // Compact the even bits into the low 32
+    x = (x | (x >> 1)) & 0x3333333333333333ull;
+    x = (x | (x >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+    x = (x | (x >> 4)) & 0x00FF00FF00FF00FFull;
+    x = (x | (x >> 8)) & 0x0000FFFF0000FFFFull;
+    x = (x | (x >> 16)) & 0x00000000FFFFFFFFull;
+    return (uint32_t)x;
+}
+
+// Bit i set when values[i] > threshold, for a block of 32 values
+uint32_t value_above_bits(const float* values, float threshold) {
+    uint32_t bits = 0;
+#ifdef __SSE2__
+    __m128 t = _mm_set1_ps(threshold);
+    for (int i = 0; i < 8; i++) {
+        __m128 gt = _mm_cmpgt_ps(_mm_loadu_ps(values + i * 4), t);
+        bits |= (uint32_t)_mm_movemask_ps(gt) << (i * 4);
+    }
+#else
+    for (int i = 0; i < 32; i++) {
+        bits |= (uint32_t)(values[i] > threshold) << i;
+    }
+#endif
+    return bits;
+}
+
+// Bits of the 32-event block starting at 'start' that fall inside [lo, hi)
+uint32_t range_bits(uint64_t start, uint64_t lo, uint64_t hi) {
+    uint32_t mask = 0xFFFFFFFFu;
+    if (lo > start) mask &= 0xFFFFFFFFu << (lo - start);
+    if (hi < start + 32) mask &= (1u << (hi - start)) - 1;
+    return mask;
+}
+
+void history_event(EventHistory* h, uint64_t pos, MeterEvent* out) {
+    int slot = (int)(pos & (uint64_t)(h->capacity - 1));
+    out->id = h->base_id + (int)pos;
+    out->type = (EventType)((h->types[slot >> 5] >> ((slot & 31) * 2)) & 3);
+    out->value = h->values[slot];
+    out->timestamp = h->base_time + (time_t)h->time_delta[slot];
+}
+
+// True if nothing from 'first' on was evicted or cleared since the scan began
+int history_unchanged(EventHistory* h, uint64_t first) {
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&h->first, memory_order_relaxed) == first;
+}
+
+// Count events of 'type' with value > threshold. The newest matches (up to
+// SCAN_SHOW) are copied to 'newest'. *retained gets the history size.
+uint64_t history_scan_above(EventHistory* h, EventType type, float threshold,
+                            MeterEvent newest[SCAN_SHOW], int* shown, uint64_t* retained) {
+    uint64_t count, first, total;
+    uint64_t recent[SCAN_SHOW];
+
+    *shown = 0;
+    *retained = 0;
+    if (h->capacity == 0) return 0;
+    do {
+        total = atomic_load_explicit(&h->total, memory_order_acquire);
+        first = atomic_load_explicit(&h->first, memory_order_acquire);
+        count = 0;
+        uint64_t n_recent = 0;
+
+        for (uint64_t start = first & ~31ull; start < total; start += 32) {
+            int slot = (int)(start & (uint64_t)(h->capacity - 1));
+            uint32_t hits = type_match_bits(h->types[slot >> 5], type)
+                          & value_above_bits(h->values + slot, threshold)
+                          & range_bits(start, first, total);
+            count += (uint64_t)__builtin_popcount(hits);
+            while (hits) {
+                recent[n_recent++ % SCAN_SHOW] = start + (uint64_t)__builtin_ctz(hits);
+                hits &= hits - 1;
+            }
+        }
+
+        *shown = n_recent < SCAN_SHOW ? (int)n_recent : SCAN_SHOW;
+        for (int i = 0; i < *shown; i++) {
+            history_event(h, recent[(n_recent - *shown + i) % SCAN_SHOW], &newest[i]);
+        }
+    } while (!history_unchanged(h, first));
+
+    *retained = total - first;
+    return count;
+}
+
+// Count events of 'type' stamped at or after 'since'
+uint64_t history_count_since(EventHistory* h, EventType type, time_t since) {
+    uint64_t count, first, total;
+
+    if (h->capacity == 0) return 0;
+    do {
+        total = atomic_load_explicit(&h->total, memory_order_acquire);
+        first = atomic_load_explicit(&h->first, memory_order_acquire);
+        count = 0;
+
+        // Binary search the (monotonic) time column for the window start
+        int64_t since_delta = (int64_t)(since - h->base_time);
+        uint64_t lo = first, hi = total;
+        while (lo < hi) {
+            uint64_t mid = lo + (hi - lo) / 2;
+            if ((int64_t)h->time_delta[mid & (uint64_t)(h->capacity - 1)] < since_delta) lo = mid + 1;
+            else hi = mid;
+        }
+
+        for (uint64_t start = lo & ~31ull; start < total; start += 32) {
+            int slot = (int)(start & (uint64_t)(h->capacity - 1));
+            uint32_t hits = type_match_bits(h->types[slot >> 5], type) & range_bits(start, lo, total);
+            count += (uint64_t)__builtin_popcount(hits);
+        }
+    } while (!history_unchanged(h, first));
+
+    return count;
+}
+
+// Accepts a type label (e.g. VOLT_LVL) or its number 0-3. Returns -1 if unknown.
+int parse_event_type(const char* text) {
+    for (int t = 0; t < NUM_EVENT_TYPES; t++) {
+        if (strcmp(text, get_event_type_str((EventType)t)) == 0) return t;
+    }
+    if (text[0] >= '0' && text[0] < '0' + NUM_EVENT_TYPES && text[1] == '\0') return text[0] - '0';
+    return -1;
+}
+
+// --- Indexed Seek ---
+// Events occupy consecutive ring slots in insertion order, and add_event hands out
+// ids (and timestamps) in increasing order, so positions can be computed directly.
+
+// O(1): ids are contiguous from head to tail
+Node* find_by_id(EventLog* log, int id) {
+    if (log->count == 0) return NULL;
+    int offset = id - log->head->data.id;
+    if (offset < 0 || offset >= log->count) return NULL;
+    return event_at(log, offset);
+}
+
+// O(log n): first event at or after 'when'
+Node* find_by_time(EventLog* log, time_t when) {
+    int lo = 0, hi = log->count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (event_at(log, mid)->data.timestamp < when) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo < log->count ? event_at(log, lo) : NULL;
+}
+
+// Jump the cursor to an event id or to the first event at/after a time.
+// Returns 0 if no retained event matches.
+int seek_cursor(EventLog* log, SeekMode mode, long long key) {
+    while (1) {
+        unsigned int s = read_begin(log);
+        Node* expected = atomic_load(&log->cursor);
+        Node* target = (mode == SEEK_ID) ? find_by_id(log, (int)key)
+                                         : find_by_time(log, (time_t)key);
+        if (read_retry(log, s)) continue;
+
+        if (!target) return 0;
+        if (atomic_compare_exchange_strong(&log->cursor, &expected, target)) return 1;
+    }
+}
+
+// Convert "HH:MM:SS" (today, local time) to a timestamp. Returns 0 on bad input.
+int parse_clock_time(const char* text, time_t* out) {
+    int h, m, sec;
+    if (sscanf(text, "%d:%d:%d", &h, &m, &sec) != 3) return 0;
+    if (h < 0 || h > 23 || m < 0 || m > 59 || sec < 0 || sec > 59) return 0;
+
+    time_t now = time(NULL);
+    struct tm tm_info = *localtime(&now);
+    tm_info.tm_hour = h;
+    tm_info.tm_min = m;
+    tm_info.tm_sec = sec;
+    tm_info.tm_isdst = -1;
+    *out = mktime(&tm_info);
+    return 1;
+}
+
+// --- SPSC Ingestion Queue ---
+
+void init_queue(EventQueue* q) {
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+}
+
+// Producer side. Returns 0 if the queue is full.
+int enqueue_message(EventQueue* q, const IngestMessage* msg) {
+    unsigned int tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    unsigned int head = atomic_load_explicit(&q->head, memory_order_acquire);
+    if (tail - head == QUEUE_SIZE) return 0;
+
+    q->slots[tail & (QUEUE_SIZE - 1)] = *msg;
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+    return 1;
+}
+
+// Consumer side. Returns 0 if the queue is empty.
+int dequeue_message(EventQueue* q, IngestMessage* msg) {
+    unsigned int head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    if (head == tail) return 0;
+
+    *msg = q->slots[head & (QUEUE_SIZE - 1)];
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+    return 1;
+}
+
+// --- Live Output Stage ---
+
+void init_live_output(LiveOutput* out) {
+    out->used = 0;
+    out->cached_second = (time_t)-1;
+    out->cached_time[0] = '\0';
+    clock_gettime(CLOCK_MONOTONIC, &out->last_flush);
+    out->sample_second = 0;
+    out->sampled = 0;
+    out->suppressed = 0;
+}
+
+char* append_text(char* p, const char* text) {
+    while (*text) *p++ = *text++;
+    return p;
+}
+
+// Decimal integer, zero-padded to at least 'width' digits
+char* append_int(char* p, long long value, int width) {
+    char digits[24];
+    int n = 0;
+    unsigned long long v = value < 0 ? 0ull - (unsigned long long)value : (unsigned long long)value;
+    do {
+        digits[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    while (n < width) digits[n++] = '0';
+    if (value < 0) *p++ = '-';
+    while (n) *p++ = digits[--n];
+    return p;
+}
+
+// Same text as printf("%.2f") for the range meter readings use
+char* append_fixed2(char* p, float value) {
+    if (!(value > -1e15f && value < 1e15f)) return p + sprintf(p, "%.2f", value);
+    double scaled = value * 100.0;
+    long long cents = (long long)(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+    if (cents < 0) {
+        *p++ = '-';
+        cents = -cents;
+    }
+    p = append_int(p, cents / 100, 1);
+    *p++ = '.';
+    return append_int(p, cents % 100, 2);
+}
+
+// Write the batch in one call
+void live_flush(LiveOutput* out) {
+    if (out->used > 0) {
+        fwrite(out->buffer, 1, out->used, stdout);
+        fflush(stdout);
+        out->used = 0;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &out->last_flush);
+}
+
+void live_reserve_line(LiveOutput* out) {
+    if (out->used + LIVE_LINE_MAX > LIVE_BUFFER_SIZE) live_flush(out);
+}
+
+// Report evictions that moved the cursor and events hidden by sampling
+void live_notices(LiveOutput* out, EventLog* log) {
+    if (log->cursor_adjustments > 0) {
+        live_reserve_line(out);
+        char* p = out->buffer + out->used;
+        if (log->cursor_adjustments == 1) {
+            p = append_text(p, "<!> Oldest event removed. Cursor adjusted.\n");
+        } else {
+            p = append_text(p, "<!> ");
+            p = append_int(p, log->cursor_adjustments, 1);
+            p = append_text(p, " oldest events removed. Cursor adjusted.\n");
+        }
+        out->used = (size_t)(p - out->buffer);
+        log->cursor_adjustments = 0;
+    }
+    if (out->suppressed > 0) {
+        live_reserve_line(out);
+        char* p = out->buffer + out->used;
+        p = append_text(p, "[LIVE LOG] ... ");
+        p = append_int(p, out->suppressed, 1);
+        p = append_text(p, " more events (sampled)\n");
+        out->used = (size_t)(p - out->buffer);
+        out->suppressed = 0;
+    }
+}
+
+// Format one event for the live display, honouring the sampling budget
+void live_output_event(LiveOutput* out, EventLog* log, const MeterEvent* event, int mode) {
+    if (mode == LIVE_SAMPLED) {
+        if (event->timestamp != out->sample_second) {
+            live_notices(out, log); // Close out the previous second
+            out->sample_second = event->timestamp;
+            out->sampled = 0;
+        }
+        if (out->sampled >= LIVE_SAMPLE_RATE) {
+            out->suppressed++;
+            return;
+        }
+        out->sampled++;
+    }
+
+    if (event->timestamp != out->cached_second) {
+        struct tm tm_info;
+        localtime_r(&event->timestamp, &tm_info);
+        strftime(out->cached_time, sizeof(out->cached_time), "%H:%M:%S", &tm_info);
+        out->cached_second = event->timestamp;
+    }
+
+    live_reserve_line(out);
+    char* p = out->buffer + out->used;
+    p = append_text(p, "[LIVE LOG] ID:");
+    p = append_int(p, event->id, 3);
+    p = append_text(p, " | Time:");
+    p = append_text(p, out->cached_time);
+    p = append_text(p, " | Type:");
+    p = append_text(p, get_event_type_str(event->type));
+    p = append_text(p, " | Val:");
+    p = append_fixed2(p, event->value);
+    *p++ = '\n';
+    out->used = (size_t)(p - out->buffer);
+}
+
+// Flush if the oldest buffered line has waited long enough
+void live_flush_if_due(LiveOutput* out) {
+    struct timespec now;
+    if (out->used == 0) return;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long elapsed_ms = (now.tv_sec - out->last_flush.tv_sec) * 1000 +
+                      (now.tv_nsec - out->last_flush.tv_nsec) / 1000000;
+    if (elapsed_ms >= LIVE_FLUSH_MS) live_flush(out);
+}
+
+// --- Ingestion Thread ---
+
+void apply_message(Ingestor* ing, const IngestMessage* msg) {
+    EventLog* log = ing->log;
+    if (msg->kind == MSG_CLEAR) {
+        live_notices(&ing->live, log);
+        live_flush(&ing->live); // Keep earlier lines ahead of the clear notice
+        clear_log(log);
+        return;
+    }
+
+    Node* node = add_event(log, msg->event.type, msg->event.value, msg->event.timestamp);
+    if (!node) return;
+    int mode = atomic_load_explicit(&log->live_mode, memory_order_relaxed);
+    if (mode != LIVE_SAMPLED) live_notices(&ing->live, log); // Sampled mode batches them per second
+    if (mode != LIVE_OFF) live_output_event(&ing->live, log, &node->data, mode);
+    live_flush_if_due(&ing->live);
+}
+
+void* ingestion_loop(void* arg) {
+    Ingestor* ing = (Ingestor*)arg;
+    IngestMessage msg;
+
+    while (atomic_load(&ing->running)) {
+        if (!dequeue_message(&ing->queue, &msg)) {
+            // Burst over: show everything formatted so far
+            live_notices(&ing->live, ing->log);
+            live_flush(&ing->live);
+            if (ing->log->journal) journal_sync_if_due(ing->log->journal);
+            usleep(1000); // Idle: nothing from the sensors
+            continue;
+        }
+        apply_message(ing, &msg);
+        atomic_fetch_add_explicit(&ing->processed, 1, memory_order_release);
+    }
+
+    // Drain whatever was submitted before shutdown
+    while (dequeue_message(&ing->queue, &msg)) {
+        apply_message(ing, &msg);
+        atomic_fetch_add_explicit(&ing->processed, 1, memory_order_release);
+    }
+    live_notices(&ing->live, ing->log);
+    live_flush(&ing->live);
+    return NULL;
+}
+
+int start_ingestor(Ingestor* ing, EventLog* log) {
+    init_queue(&ing->queue);
+    init_live_output(&ing->live);
+    ing->log = log;
+    ing->submitted = 0;
+    atomic_init(&ing->processed, 0);
+    atomic_init(&ing->running, 1);
+    if (pthread_create(&ing->thread, NULL, ingestion_loop, ing) != 0) {
+        printf("Error: Could not start ingestion thread.\n");
+        return 0;
+    }
+    return 1;
+}
+
+void stop_ingestor(Ingestor* ing) {
+    atomic_store(&ing->running, 0);
+    pthread_join(ing->thread, NULL);
+}
+
+// Hand a message to the ingestion thread without waiting for it
+int submit_message(Ingestor* ing, MessageType kind, const MeterEvent* event) {
+    IngestMessage msg;
+    msg.kind = kind;
+    if (event) msg.event = *event;
+    if (!enqueue_message(&ing->queue, &msg)) return 0;
+    ing->submitted++;
+    return 1;
+}
+
+// Block until every submitted message has been applied (used for console commands)
+void wait_for_ingestion(Ingestor* ing) {
+    while (atomic_load_explicit(&ing->processed, memory_order_acquire) != ing->submitted) {
+        usleep(100);
+    }
+}
+
 // --- Simulation Helper ---
-// Simulates a sensor reading
-void simulate_hardware_event(EventLog* log) {
-    int r = rand() % 4;
-    float val = (float)(rand() % 100) + ((rand() % 10) * 0.1);
-    add_event(log, (EventType)r, val);
+// Random reading with the distribution the hardware simulation has always used
+void generate_reading(MeterEvent* event) {
+    event->id = 0; // Assigned on ingestion
+    event->type = (EventType)(rand() % 4);
+    event->value = (float)(rand() % 100) + ((rand() % 10) * 0.1);
+    event->timestamp = time(NULL);
+}
+
+// Simulates a sensor reading and hands it to the ingestion thread
+void simulate_hardware_event(Ingestor* ing) {
+    MeterEvent event;
+    generate_reading(&event);
+    if (!submit_message(ing, MSG_EVENT, &event)) {
+        printf("Error: Ingestion queue full, signal dropped.\n");
+    }
+}
+
+// --- Benchmark Mode ---
+// Drives the log directly on one thread (no queue, no console) so the cost of the
+// data structure itself is visible: ingestion with and without eviction, cursor
+// steps and seeks.
+
+typedef struct {
+    long long counts[LAT_BUCKETS];
+    long long overflow;
+    long long samples;
+    long long max;
+} LatencyHist;
+
+long long elapsed_ns(const struct timespec* a, const struct timespec* b) {
+    return (b->tv_sec - a->tv_sec) * 1000000000LL + (b->tv_nsec - a->tv_nsec);
+}
+
+void record_latency(LatencyHist* h, long long ns) {
+    if (ns < LAT_BUCKETS) h->counts[ns]++;
+    else h->overflow++;
+    if (ns > h->max) h->max = ns;
+    h->samples++;
+}
+
+// Smallest latency at or above fraction q of the samples (-1 if in the overflow bin)
+long long latency_percentile(const LatencyHist* h, double q) {
+    long long rank = (long long)(q * h->samples);
+    long long seen = 0;
+    for (int i = 0; i < LAT_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen > rank) return i;
+    }
+    return -1;
+}
+
+void print_latency(const char* label, const LatencyHist* h) {
+    double qs[4] = {0.50, 0.90, 0.99, 0.999};
+    const char* names[4] = {"p50", "p90", "p99", "p99.9"};
+
+    if (h->samples == 0) {
+        printf("%-18s no samples\n", label);
+        return;
+    }
+    printf("%-18s", label);
+    for (int i = 0; i < 4; i++) {
+        long long v = latency_percentile(h, qs[i]);
+        if (v < 0) printf(" %s >%d |", names[i], LAT_BUCKETS - 1);
+        else printf(" %s %lld |", names[i], v);
+    }
+    printf(" max %lld (ns, %lld samples)\n", h->max, h->samples);
+}
+
+int run_benchmark(EventLog* log, long long total_events) {
+    static LatencyHist fill_lat, evict_lat;
+    struct timespec run_start, run_end, t0, t1;
+    MeterEvent event;
+    time_t base_time = time(NULL);
+
+    memset(&fill_lat, 0, sizeof(fill_lat));
+    memset(&evict_lat, 0, sizeof(evict_lat));
+
+    printf("\n--- Energy Meter Benchmark ---\n");
+    printf("Events: %lld | Buffer: %d | History: %d | Journal: %s | Tiers: %s\n",
+           total_events, log->capacity, log->history.capacity,
+           log->journal ? "on" : "off", log->tiered ? "on" : "off");
+
+    // 1. Ingestion (synthetic clock: 1000 events per second)
+    clock_gettime(CLOCK_MONOTONIC, &run_start);
+    for (long long i = 0; i < total_events; i++) {
+        generate_reading(&event);
+        int evicts = log->count >= log->capacity;
+
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        add_event(log, event.type, event.value, base_time + (time_t)(i / 1000));
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+
+        record_latency(evicts ? &evict_lat : &fill_lat, elapsed_ns(&t0, &t1));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &run_end);
+    log->cursor_adjustments = 0;
+
+    double secs = elapsed_ns(&run_start, &run_end) / 1e9;
+    printf("Ingest:            %.3f s | %.2f M events/s | %.1f ns/event (incl. generation and timing)\n",
+           secs, total_events / secs / 1e6, secs * 1e9 / total_events);
+    print_latency("add_event:", &fill_lat);
+    print_latency("add_event+evict:", &evict_lat);
+
+    // 2. Cursor navigation: walk the whole buffer forward, then back
+    long long steps = 0;
+    atomic_store(&log->cursor, log->head);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    while (move_cursor(log, 1)) steps++;
+    while (move_cursor(log, -1)) steps++;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if (steps > 0) {
+        printf("Cursor step (n/p): %.1f ns/step over %lld steps\n", (double)elapsed_ns(&t0, &t1) / steps, steps);
+    }
+
+    // 3. Indexed seeks to random retained events
+    int seeks = 1000000;
+    int oldest = log->head->data.id;
+    time_t oldest_time = log->head->data.timestamp;
+    time_t span = log->tail->data.timestamp - oldest_time + 1;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < seeks; i++) seek_cursor(log, SEEK_ID, oldest + rand() % log->count);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    printf("Seek by ID:        %.1f ns/seek\n", (double)elapsed_ns(&t0, &t1) / seeks);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < seeks; i++) seek_cursor(log, SEEK_TIME, oldest_time + rand() % span);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    printf("Seek by time:      %.1f ns/seek\n", (double)elapsed_ns(&t0, &t1) / seeks);
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf("Peak RSS:          %.1f MB\n", usage.ru_maxrss / 1024.0);
+    printf("------------------------------\n");
+    return 0;
 }
 
 // --- Main Interface ---
 
-int main() {
+int main(int argc, char* argv[]) {
+    int capacity = MAX_EVENTS;
+    int history_capacity = -1; // Default: HISTORY_FACTOR buffers
+    int tiered = 0;
+    const char* journal_path = DEFAULT_JOURNAL;
+    int journal_given = 0;
+    double bench_millions = 0.0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:j:JH:Tb:")) != -1) {
+        switch (opt) {
+            case 'n':
+                capacity = atoi(optarg);
+                break;
+            case 'j':
+                journal_path = optarg;
+                journal_given = 1;
+                break;
+            case 'J': // Run without persistence
+                journal_path = NULL;
+                break;
+            case 'H':
+                history_capacity = atoi(optarg);
+                break;
+            case 'T': // Keep downsampled aggregates of evicted events
+                tiered = 1;
+                break;
+            case 'b': // Headless benchmark with this many million events
+                bench_millions = atof(optarg);
+                break;
+            default:
+                printf("Usage: %s [-n buffer_size] [-j journal_file | -J] [-H history_events] [-T] [-b million_events]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (capacity <= 0) {
+        printf("Error: Buffer size must be positive.\n");
+        return 1;
+    }
+
+    if (history_capacity < 0) {
+        history_capacity = capacity > (1 << 30) / HISTORY_FACTOR ? (1 << 30) : capacity * HISTORY_FACTOR;
+    }
+
     srand(time(NULL));
     EventLog log;
-    init_log(&log);
+    if (!init_log(&log, capacity, history_capacity)) return 1;
+    if (tiered && !init_tiers(&log)) {
+        free_log(&log);
+        return 1;
+    }
+
+    if (bench_millions > 0) {
+        // Only journal when asked, so a benchmark never overwrites saved events
+        Journal bench_journal;
+        if (journal_given && !journal_open(&bench_journal, journal_path, &log)) {
+            free_log(&log);
+            return 1;
+        }
+        long long total = (long long)(bench_millions * 1e6);
+        int status = run_benchmark(&log, total > 0 ? total : 1);
+        if (log.journal) journal_close(&bench_journal, &log);
+        free_log(&log);
+        return status;
+    }
+
+    Journal journal;
+    if (journal_path && !journal_open(&journal, journal_path, &log)) {
+        free_log(&log);
+        return 1;
+    }
+
+    static Ingestor ingestor; // Queue is too large for the stack
+    if (!start_ingestor(&ingestor, &log)) {
+        if (log.journal) journal_close(&journal, &log);
+        free_log(&log);
+        return 1;
+    }
 
     char command;
     int running = 1;
+    LogView view;
+    int target_id;
+    char time_text[16];
+    time_t target_time;
+    char type_text[16];
+    float threshold;
+    int seconds;
+    MeterEvent matches[SCAN_SHOW];
+    int shown;
+    uint64_t found, retained;
+    char tier_choice;
 
     // Pre-populate a few events for testing
     printf("Booting firmware... detecting initial signals...\n");
-    simulate_hardware_event(&log);
-    simulate_hardware_event(&log);
-    simulate_hardware_event(&log);
+    simulate_hardware_event(&ingestor);
+    simulate_hardware_event(&ingestor);
+    simulate_hardware_event(&ingestor);
+    wait_for_ingestion(&ingestor);
 
     while (running) {
-        printf("\n--- Energy Gateway (Events: %d/%d) [Live: %s] ---\n", 
-               log.count, MAX_EVENTS, log.live_mode ? "ON" : "OFF");
-        
+        read_log_view(&log, &view);
+        int live = atomic_load(&log.live_mode);
+        printf("\n--- Energy Gateway (Events: %d/%d) [Live: %s] ---\n",
+               view.count, log.capacity, live == LIVE_ALL ? "ON" : live == LIVE_SAMPLED ? "SAMPLED" : "OFF");
+
         // Show current cursor position
-        print_event(log.cursor, "CURSOR");
+        print_event(view.has_event ? &view.event : NULL, "CURSOR");
 
-        printf("Commands: (n)ext, (p)rev, (r)esume live, (h)alt live, (x)it, (c)lear, (+)sim event: ");
-        scanf(" %c", &command);
+        printf("Commands: (n)ext, (p)rev, (r)esume live, (m) sampled live, (h)alt live, (j)ump to ID, (t)ime seek, (s)tats, (v)alue scan, (f)ault count, (g)raph trend, (x)it, (c)lear, (+)sim event: ");
+        if (scanf(" %c", &command) != 1) command = 'x'; // End of input
 
         switch (command) {
             case 'n': // Next (Newer)
-                if (log.cursor && log.cursor->next) {
-                    log.cursor = log.cursor->next;
-                } else {
+                if (!move_cursor(&log, 1)) {
                     printf(">> End of history.\n");
                 }
                 break;
 
             case 'p': // Previous (Older)
-                if (log.cursor && log.cursor->prev) {
-                    log.cursor = log.cursor->prev;
-                } else {
+                if (!move_cursor(&log, -1)) {
                     printf(">> Start of history.\n");
                 }
                 break;
 
+            case 'j': // Jump to Event ID
+                printf("Enter event ID: ");
+                if (scanf("%d", &target_id) != 1) {
+                    scanf("%*s"); // Discard the bad token
+                    printf(">> Invalid ID.\n");
+                } else if (!seek_cursor(&log, SEEK_ID, target_id)) {
+                    read_log_view(&log, &view);
+                    printf(">> Event %d is not in the buffer (IDs %d-%d).\n",
+                           target_id, view.oldest_id, view.newest_id);
+                }
+                break;
+
+            case 't': // Jump to Time
+                printf("Enter time (HH:MM:SS): ");
+                if (scanf("%15s", time_text) != 1 || !parse_clock_time(time_text, &target_time)) {
+                    printf(">> Invalid time.\n");
+                } else if (!seek_cursor(&log, SEEK_TIME, target_time)) {
+                    printf(">> No events at or after %s.\n", time_text);
+                }
+                break;
+
+            case 's': // Window Statistics
+                print_stats(&log);
+                break;
+
+            case 'v': // History Scan: type above threshold
+                printf("Enter type (PWR_CONS/VOLT_LVL/FREQ_STB/FAULT_ALRT) and threshold: ");
+                if (scanf("%15s %f", type_text, &threshold) != 2 || parse_event_type(type_text) < 0) {
+                    printf(">> Invalid type or threshold.\n");
+                    break;
+                }
+                found = history_scan_above(&log.history, (EventType)parse_event_type(type_text),
+                                           threshold, matches, &shown, &retained);
+                printf(">> %llu %s events above %.2f in history (%llu retained).\n",
+                       (unsigned long long)found, type_text, threshold, (unsigned long long)retained);
+                for (int i = 0; i < shown; i++) print_event(&matches[i], "MATCH");
+                break;
+
+            case 'f': // History Scan: recent faults
+                printf("Enter window in seconds: ");
+                if (scanf("%d", &seconds) != 1 || seconds < 0) {
+                    printf(">> Invalid window.\n");
+                    break;
+                }
+                found = history_count_since(&log.history, FAULT_ALERT, time(NULL) - seconds);
+                printf(">> %llu FAULT_ALRT events in the last %d seconds.\n", (unsigned long long)found, seconds);
+                break;
+
+            case 'g': // Downsampled Trend of Evicted Events
+                if (!log.tiered) {
+                    printf(">> Tiered retention is off (start with -T).\n");
+                    break;
+                }
+                printf("Enter resolution (s)econd, (m)inute, (h)our: ");
+                if (scanf(" %c", &tier_choice) != 1) break;
+                if (tier_choice == 's') print_trend(&log, 0);
+                else if (tier_choice == 'm') print_trend(&log, 1);
+                else if (tier_choice == 'h') print_trend(&log, 2);
+                else printf(">> Invalid resolution.\n");
+                break;
+
             case 'r': // Resume Live Display
-                log.live_mode = 1;
+                atomic_store(&log.live_mode, LIVE_ALL);
                 printf(">> Live display STARTED.\n");
                 break;
 
+            case 'm': // Sampled Live Display (rate-limited)
+                atomic_store(&log.live_mode, LIVE_SAMPLED);
+                printf(">> Live display SAMPLED (max %d events/sec shown).\n", LIVE_SAMPLE_RATE);
+                break;
+
             case 'h': // Halt Live Display
-                log.live_mode = 0;
+                atomic_store(&log.live_mode, LIVE_OFF);
                 printf(">> Live display PAUSED (events still collecting).\n");
                 break;
-            
-            case 'c': // Clear
-                clear_log(&log);
+
+            case 'c': // Clear (ordered after any queued signals)
+                while (!submit_message(&ingestor, MSG_CLEAR, NULL)) usleep(100);
+                wait_for_ingestion(&ingestor);
                 break;
 
             case 'x': // Exit
                 printf(">> Saving state... System Shutdown.\n");
+                stop_ingestor(&ingestor);
+                if (log.journal) journal_close(&journal, &log); // Detach first so the journal keeps its events
                 clear_log(&log); // Cleanup before exit
+                free_log(&log);
                 running = 0;
                 break;
-            
+
             case '+': // HIDDEN/TEST COMMAND: Manually trigger a sensor event
                 printf(">> Sensor signal received...\n");
-                simulate_hardware_event(&log);
+                simulate_hardware_event(&ingestor);
                 break;
 
             default:
@@ -1,156 +1,1642 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 
 #define MAX_CMD_LEN 50
-#define MAX_COMMANDS 40
 #define TYPO_THRESHOLD 3
+#define MIN_PREFIX_LEN 3     // Shortest input completed as a truncated command
+#define COMPLETE_SHOW 10     // Completions listed by the '?' command
+#define CACHE_SIZE 1024      // Remembered verdicts for inputs that missed exactly
+#define CACHE_BUCKETS 2048   // Hash buckets for the verdict cache (power of two)
+#define CACHE_SHARDS 16      // Independently locked slices of the cache (power of two)
+#define SHARD_SIZE (CACHE_SIZE / CACHE_SHARDS)
+#define SHARD_BUCKETS (CACHE_BUCKETS / CACHE_SHARDS)
+#define COMMANDS_FILE "approved_commands.txt"
+#define RELOAD_POLL_MS 1000  // How often the command file is checked for changes
+#define MAX_READERS 64       // Threads that may hold an index snapshot at once
+#define LOG_FILE "unrecognized.log"
+#define LOG_WINDOW_SIZE 256  // Distinct rejected commands held per flush window
+#define LOG_FLUSH_MS 500     // Flush window for the background log writer
+#define BATCH_CHUNK (1 << 20) // Bytes of input handled per batch-mode round
+#define MAX_WORKERS 16
+#define DAEMON_WORKERS 4      // Default thread pool size for daemon mode
+#define CLIENT_BUF_SIZE (64 * 1024) // Per-client input buffer; also the reply backlog limit
+#define MAX_EVENTS 64         // epoll events handled per wakeup
+
+// Where load/reload/log notices go: stdout at the terminal, stderr in batch mode
+// so the verdict stream stays clean
+FILE* status_out;
 
 // --- Data Structures ---
-typedef struct TreeNode {
-    char command[MAX_CMD_LEN];
-    struct TreeNode* left;
-    struct TreeNode* right;
-} TreeNode;
+
+// One slot of the search tree. The first 8 bytes of the command are packed
+// big-endian into 'prefix', so most comparisons never touch the string itself.
+typedef struct {
+    uint64_t prefix;
+    int index;          // Position in CommandIndex.commands
+} IndexSlot;
+
+// BK-tree node for typo search. Every child's edit distance to this node's
+// command is 'distance', so the triangle inequality lets whole subtrees be skipped.
+typedef struct {
+    int command;        // Position in CommandIndex.commands
+    int distance;       // Edit distance to the parent's command
+    int first_child;    // -1 if none
+    int next_sibling;   // -1 if none
+    int max_child;      // Largest 'distance' among the children
+} BKNode;
+
+// Radix trie node. Commands are sorted, so a node's subtree is the contiguous
+// run commands[lo..hi); its edge label is commands[lo][start..end).
+typedef struct {
+    int lo, hi;
+    int start, end;
+    int first_child;    // -1 if none; siblings ascend by first label character
+    int next_sibling;   // -1 if none
+} RadixNode;
+
+// Immutable lookup index built once at load time: the sorted command list plus
+// the same order laid out as an implicit tree in Eytzinger (BFS) order.
+typedef struct {
+    char (*commands)[MAX_CMD_LEN]; // Sorted, no duplicates
+    int count;
+    IndexSlot* tree;               // tree[1..count]; children of k are 2k and 2k+1
+    BKNode* bk;                    // bk[0] is the root; one node per command
+    RadixNode* trie;               // trie[0] is the root; at most 2 * count nodes
+    int trie_count;
+    unsigned long generation;      // Publish number; cached verdicts carry it
+} CommandIndex;
+
+typedef enum {
+    VERDICT_OK,
+    VERDICT_SUGGEST,
+    VERDICT_REJECT
+} Verdict;
+
+typedef struct {
+    char input[MAX_CMD_LEN];
+    char match[MAX_CMD_LEN];       // Suggestion, for VERDICT_SUGGEST
+    Verdict verdict;
+    int bucket_next;               // Chain within the hash bucket, -1 at the end
+    int newer, older;              // LRU list neighbours, -1 at either end
+} CacheEntry;
+
+// One slice of the verdict cache: a bounded LRU map with its own lock
+typedef struct {
+    pthread_mutex_t lock;
+    CacheEntry entries[SHARD_SIZE];
+    int buckets[SHARD_BUCKETS];    // First entry per bucket, -1 if empty
+    int newest, oldest;
+    int used;
+    unsigned long generation;      // Index generation the entries were computed on
+    unsigned long hits, misses;
+} __attribute__((aligned(64))) CacheShard;
+
+// Map from a mistyped input to its verdict, so a repeated typo skips the prefix
+// and fuzzy searches. The key hash picks a shard, so threads only contend when
+// they look up inputs that land in the same slice.
+typedef struct {
+    CacheShard shards[CACHE_SHARDS];
+} VerdictCache;
+
+// Published command set. Readers never lock: they announce the snapshot they are
+// using in a hazard slot, and the reloader frees a replaced snapshot only once no
+// slot still points at it.
+typedef struct {
+    _Atomic(CommandIndex*) current;
+    _Atomic(CommandIndex*) hazards[MAX_READERS];
+    atomic_int readers;             // Hazard slots handed out so far
+    atomic_ulong generation;        // Bumped on every publish
+    VerdictCache cache;
+    const char* filename;
+    struct stat seen;               // File identity/mtime behind 'current'
+    pthread_t thread;
+    atomic_int running;
+} CommandStore;
+
+// Rejection log. The request path only bumps a counter in the current window
+// (a repeat costs one hash probe); a background writer swaps the window out once
+// per flush interval and writes it through one open handle.
+typedef struct {
+    char pending[LOG_WINDOW_SIZE][MAX_CMD_LEN]; // Distinct commands, first-seen order
+    int counts[LOG_WINDOW_SIZE];
+    int slots[LOG_WINDOW_SIZE * 2]; // Open-addressed: hash -> pending index, -1 empty
+    int count;
+    unsigned long dropped;          // New commands turned away from a full window
+    FILE* file;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_t thread;
+    int running;
+} RejectLog;
 
 // --- Helper: Levenshtein Distance (for typo suggestions) ---
-// Calculates the minimum number of single-character edits required to change s1 into s2
-int calculate_edit_distance(const char* s1, const char* s2) {
-    int len1 = strlen(s1);
-    int len2 = strlen(s2);
-    int matrix[len1 + 1][len2 + 1];
+// Myers' bit-parallel algorithm (Hyyro's variant for edit distance). Each command
+// fits in one 64-bit word, so a whole DP column is updated with a handful of
+// word operations per character instead of one cell at a time.
+
+_Static_assert(MAX_CMD_LEN <= 64, "commands must fit in one 64-bit column");
+
+#define BATCH_LANES 4   // Candidates scored together by myers_distance_batch
+
+// Per-character match masks for the string being compared against many others
+typedef struct {
+    uint64_t peq[256];  // Bit i set where pattern[i] == c
+    int len;
+} EditPattern;
+
+void init_edit_pattern(EditPattern* p, const char* pattern) {
+    memset(p->peq, 0, sizeof(p->peq));
+    p->len = strlen(pattern);
+    for (int i = 0; i < p->len; i++) p->peq[(unsigned char)pattern[i]] |= 1ull << i;
+}
+
+// Edit distance from the pattern to 'text'. Gives up once the result must
+// exceed 'max' and returns max + 1.
+int myers_distance(const EditPattern* p, const char* text, int max) {
+    int n = strlen(text);
+    if (abs(p->len - n) > max) return max + 1; // Length gap alone is too many edits
+    if (p->len == 0) return n;
+
+    uint64_t pv = ~0ull, mv = 0;
+    uint64_t high = 1ull << (p->len - 1);
+    int score = p->len;
+
+    for (int j = 0; j < n; j++) {
+        uint64_t eq = p->peq[(unsigned char)text[j]];
+        uint64_t xv = eq | mv;
+        uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        uint64_t ph = mv | ~(xh | pv);
+        uint64_t mh = pv & xh;
+        if (ph & high) score++;
+        if (mh & high) score--;
+        ph = (ph << 1) | 1; // Top row of the DP grows by one per text character
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+
+        // The remaining characters can lower the score by at most one each
+        if (score - (n - 1 - j) > max) return max + 1;
+    }
+    return score;
+}
+
+#if defined(__GNUC__)
+typedef uint64_t LaneBits __attribute__((vector_size(8 * BATCH_LANES)));
+typedef int64_t LaneScores __attribute__((vector_size(8 * BATCH_LANES)));
+#endif
+
+// Exact distances from the pattern to up to BATCH_LANES texts in one pass.
+// Each vector lane runs the Myers recurrence for a different text; with AVX2 a
+// lane step is one instruction, otherwise the compiler splits it into SSE2 pairs.
+void myers_distance_batch(const EditPattern* p, const char* texts[], int count, int out[]) {
+#if defined(__GNUC__)
+    int lens[BATCH_LANES] = {0};
+    int longest = 0;
+    for (int lane = 0; lane < count; lane++) {
+        lens[lane] = strlen(texts[lane]);
+        out[lane] = lens[lane]; // Final answer if the pattern is empty
+        if (lens[lane] > longest) longest = lens[lane];
+    }
+    if (p->len == 0) return;
+    for (int lane = 0; lane < count; lane++) {
+        if (lens[lane] == 0) out[lane] = p->len;
+    }
 
-    for (int i = 0; i <= len1; i++) matrix[i][0] = i;
-    for (int j = 0; j <= len2; j++) matrix[0][j] = j;
+    LaneBits pv = ~(LaneBits){0};
+    LaneBits mv = (LaneBits){0};
+    LaneBits high = (LaneBits){0} + (1ull << (p->len - 1));
+    LaneScores score = (LaneScores){0} + p->len;
 
-    for (int i = 1; i <= len1; i++) {
-        for (int j = 1; j <= len2; j++) {
-            int cost = (s1[i - 1] == s2[j - 1]) ? 0 : 1;
-            int del = matrix[i - 1][j] + 1;
-            int ins = matrix[i][j - 1] + 1;
-            int sub = matrix[i - 1][j - 1] + cost;
-            
-            // Find minimum of del, ins, sub
-            int min = del < ins ? del : ins;
-            matrix[i][j] = min < sub ? min : sub;
+    for (int j = 0; j < longest; j++) {
+        LaneBits eq = {0};
+        for (int lane = 0; lane < count; lane++) {
+            if (j < lens[lane]) eq[lane] = p->peq[(unsigned char)texts[lane][j]];
+        }
+        LaneBits xv = eq | mv;
+        LaneBits xh = (((eq & pv) + pv) ^ pv) | eq;
+        LaneBits ph = mv | ~(xh | pv);
+        LaneBits mh = pv & xh;
+        score -= (LaneScores)((ph & high) != 0); // Comparisons yield -1 per true lane
+        score += (LaneScores)((mh & high) != 0);
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+
+        for (int lane = 0; lane < count; lane++) {
+            if (j == lens[lane] - 1) out[lane] = (int)score[lane];
         }
     }
-    return matrix[len1][len2];
+#else
+    for (int lane = 0; lane < count; lane++) out[lane] = myers_distance(p, texts[lane], MAX_CMD_LEN);
+#endif
 }
 
-// --- Core BST Operations ---
+// --- Static Index Operations ---
 
-// Create a new BST node
-TreeNode* create_node(const char* cmd) {
-    TreeNode* new_node = (TreeNode*)malloc(sizeof(TreeNode));
-    if (new_node) {
-        strncpy(new_node->command, cmd, MAX_CMD_LEN);
-        new_node->command[MAX_CMD_LEN - 1] = '\0'; // Ensure null-termination
-        new_node->left = NULL;
-        new_node->right = NULL;
+// First 8 characters packed big-endian, so integer order matches strcmp order
+uint64_t command_prefix(const char* cmd) {
+    uint64_t key = 0;
+    int i = 0;
+    for (; i < 8 && cmd[i]; i++) key = (key << 8) | (unsigned char)cmd[i];
+    return key << (8 * (8 - i));
+}
+
+int compare_commands(const void* a, const void* b) {
+    return strcmp((const char*)a, (const char*)b);
+}
+
+// In-order walk of the implicit tree hands out sorted positions
+int fill_eytzinger(CommandIndex* index, int sorted_pos, int k) {
+    if (k > index->count) return sorted_pos;
+    sorted_pos = fill_eytzinger(index, sorted_pos, 2 * k);
+    index->tree[k].prefix = command_prefix(index->commands[sorted_pos]);
+    index->tree[k].index = sorted_pos;
+    sorted_pos++;
+    return fill_eytzinger(index, sorted_pos, 2 * k + 1);
+}
+
+// Insert every command into the BK-tree (node i holds command i)
+void build_bk_tree(CommandIndex* index) {
+    EditPattern pattern;
+    for (int i = 0; i < index->count; i++) {
+        BKNode* node = &index->bk[i];
+        node->command = i;
+        node->distance = 0;
+        node->first_child = -1;
+        node->next_sibling = -1;
+        node->max_child = 0;
+        if (i == 0) continue;
+
+        init_edit_pattern(&pattern, index->commands[i]);
+        int parent = 0;
+        while (1) {
+            int d = myers_distance(&pattern, index->commands[index->bk[parent].command], MAX_CMD_LEN);
+            int child = index->bk[parent].first_child;
+            while (child != -1 && index->bk[child].distance != d) child = index->bk[child].next_sibling;
+
+            if (child == -1) {
+                node->distance = d;
+                node->next_sibling = index->bk[parent].first_child;
+                index->bk[parent].first_child = i;
+                if (d > index->bk[parent].max_child) index->bk[parent].max_child = d;
+                break;
+            }
+            parent = child;
+        }
     }
-    return new_node;
 }
 
-// Insert a command into the BST
-TreeNode* insert_command(TreeNode* root, const char* cmd) {
-    if (root == NULL) return create_node(cmd);
+// Build the trie node for commands[lo..hi), which all share their first 'start'
+// characters. Returns the node's position.
+int build_radix(CommandIndex* index, int lo, int hi, int start) {
+    const char* first = index->commands[lo];
+    const char* last = index->commands[hi - 1];
+    int end = start;
+    // Sorted order: the range's common prefix is that of its first and last entries
+    while (first[end] && first[end] == last[end]) end++;
+
+    int id = index->trie_count++;
+    RadixNode* node = &index->trie[id];
+    node->lo = lo;
+    node->hi = hi;
+    node->start = start;
+    node->end = end;
+    node->first_child = -1;
+    node->next_sibling = -1;
 
-    int cmp = strcmp(cmd, root->command);
-    if (cmp < 0) {
-        root->left = insert_command(root->left, cmd);
-    } else if (cmp > 0) {
-        root->right = insert_command(root->right, cmd);
+    int i = lo;
+    if (first[end] == '\0') i++; // The node's own command sorts first
+    int prev = -1;
+    while (i < hi) {
+        char c = index->commands[i][end];
+        int j = i + 1;
+        while (j < hi && index->commands[j][end] == c) j++;
+        int child = build_radix(index, i, j, end);
+        if (prev == -1) index->trie[id].first_child = child;
+        else index->trie[prev].next_sibling = child;
+        prev = child;
+        i = j;
     }
-    return root; // Exact duplicates are ignored
+    return id;
 }
 
-// Search for an exact match in the BST
-int search_exact(TreeNode* root, const char* cmd) {
-    if (root == NULL) return 0; // Not found
+// Find the commands starting with 'prefix' in O(|prefix|) steps. Returns how many
+// there are; they are commands[*first .. *first + count).
+int find_prefix(const CommandIndex* index, const char* prefix, int* first) {
+    if (index->trie_count == 0) return 0;
+    int node = 0;
+    int pos = 0;
+    while (1) {
+        const RadixNode* n = &index->trie[node];
+        const char* label = index->commands[n->lo];
+        for (int i = n->start; i < n->end && prefix[pos]; i++, pos++) {
+            if (label[i] != prefix[pos]) return 0;
+        }
+        if (prefix[pos] == '\0') {
+            *first = n->lo;
+            return n->hi - n->lo;
+        }
+        // Label fully matched: branch on the next character
+        int child = n->first_child;
+        while (child != -1 && index->commands[index->trie[child].lo][n->end] != prefix[pos]) {
+            child = index->trie[child].next_sibling;
+        }
+        if (child == -1) return 0;
+        node = child;
+    }
+}
+
+// Sort, drop duplicates and lay out the search trees. Takes ownership of 'commands'.
+CommandIndex* build_index(char (*commands)[MAX_CMD_LEN], int count) {
+    CommandIndex* index = (CommandIndex*)malloc(sizeof(CommandIndex));
+    if (!index) {
+        free(commands);
+        return NULL;
+    }
 
-    int cmp = strcmp(cmd, root->command);
-    if (cmp == 0) return 1; // Exact match found
-    if (cmp < 0) return search_exact(root->left, cmd);
-    return search_exact(root->right, cmd);
+    qsort(commands, (size_t)count, MAX_CMD_LEN, compare_commands);
+    int unique = 0;
+    for (int i = 0; i < count; i++) {
+        if (unique == 0 || strcmp(commands[i], commands[unique - 1]) != 0) {
+            if (unique != i) memcpy(commands[unique], commands[i], MAX_CMD_LEN);
+            unique++;
+        }
+    }
+
+    index->commands = commands;
+    index->count = unique;
+    index->tree = (IndexSlot*)malloc(sizeof(IndexSlot) * (size_t)(unique + 1));
+    index->bk = (BKNode*)malloc(sizeof(BKNode) * (size_t)(unique + 1));
+    index->trie = (RadixNode*)malloc(sizeof(RadixNode) * (size_t)(2 * unique + 1));
+    index->trie_count = 0;
+    if (!index->tree || !index->bk || !index->trie) {
+        free(index->tree);
+        free(index->bk);
+        free(index->trie);
+        free(commands);
+        free(index);
+        return NULL;
+    }
+    fill_eytzinger(index, 0, 1);
+    build_bk_tree(index);
+    if (unique > 0) build_radix(index, 0, unique, 0);
+    return index;
 }
 
-// Traverse the BST to find the closest matching string (for typos)
-void find_closest_match(TreeNode* root, const char* input_cmd, char* best_match, int* min_dist) {
-    if (root == NULL) return;
+// Search for an exact match. Walks the tree top-down without branching on the
+// result; siblings are adjacent in memory, so each level costs at most one miss.
+int search_exact(const CommandIndex* index, const char* cmd) {
+    uint64_t key = command_prefix(cmd);
+    int k = 1;
 
-    int current_dist = calculate_edit_distance(input_cmd, root->command);
-    
-    if (current_dist < *min_dist) {
-        *min_dist = current_dist;
-        strcpy(best_match, root->command);
+    while (k <= index->count) {
+        const IndexSlot* slot = &index->tree[k];
+        int less = slot->prefix < key ||
+                   (slot->prefix == key && strcmp(index->commands[slot->index], cmd) < 0);
+        k = 2 * k + less;
     }
+    // Undo the trailing right turns to land on the first slot >= cmd
+    k >>= __builtin_ffs(~k);
+    return k != 0 && strcmp(index->commands[index->tree[k].index], cmd) == 0;
+}
+
+// Search the BK-tree for the closest matching string (for typos).
+// Only distances below the incoming *min_dist are looked for; the search radius
+// then shrinks to the best distance found. Ties go to the alphabetically first command.
+void find_closest_match(const CommandIndex* index, const char* input_cmd, char* best_match, int* min_dist) {
+    if (index->count == 0) return;
+
+    int radius = *min_dist - 1;
+    int best = -1;
+    int* stack = (int*)malloc(sizeof(int) * (size_t)index->count);
+    if (!stack) return;
+    int top = 0;
+    stack[top++] = 0;
+
+    EditPattern pattern;
+    init_edit_pattern(&pattern, input_cmd);
+
+    while (top > 0) {
+        // Score up to BATCH_LANES pending nodes together
+        const BKNode* nodes[BATCH_LANES];
+        const char* texts[BATCH_LANES];
+        int dists[BATCH_LANES];
+        int batch = top < BATCH_LANES ? top : BATCH_LANES;
+
+        for (int b = 0; b < batch; b++) {
+            nodes[b] = &index->bk[stack[--top]];
+            texts[b] = index->commands[nodes[b]->command];
+        }
+        if (batch == 1) {
+            // Alone, use the early-exit kernel; the exact distance is only needed
+            // while some child could still be in range
+            dists[0] = myers_distance(&pattern, texts[0], radius + nodes[0]->max_child);
+        } else {
+            myers_distance_batch(&pattern, texts, batch, dists);
+        }
 
-    find_closest_match(root->left, input_cmd, best_match, min_dist);
-    find_closest_match(root->right, input_cmd, best_match, min_dist);
+        for (int b = 0; b < batch; b++) {
+            const BKNode* node = nodes[b];
+            int d = dists[b];
+
+            if (d <= radius && (best == -1 || d < *min_dist || node->command < best)) {
+                best = node->command;
+                *min_dist = d;
+                radius = d;
+            }
+
+            // Triangle inequality: only children with |child.distance - d| <= radius can match
+            for (int c = node->first_child; c != -1; c = index->bk[c].next_sibling) {
+                if (abs(index->bk[c].distance - d) <= radius) stack[top++] = c;
+            }
+        }
+    }
+    free(stack);
+
+    if (best != -1) strcpy(best_match, index->commands[best]);
 }
 
-// Free the BST memory (Post-order traversal)
-void free_tree(TreeNode* root) {
-    if (root == NULL) return;
-    free_tree(root->left);
-    free_tree(root->right);
-    free(root);
+void free_index(CommandIndex* index) {
+    if (index == NULL) return;
+    free(index->commands);
+    free(index->tree);
+    free(index->bk);
+    free(index->trie);
+    free(index);
 }
 
 // --- File I/O Operations ---
 
-// Load commands from a file into the BST
-TreeNode* load_approved_commands(const char* filename, int* count) {
+// Load commands from a file and build the lookup index (no fixed limit)
+CommandIndex* load_approved_commands(const char* filename, int* count) {
     FILE* file = fopen(filename, "r");
     if (!file) {
-        printf("Error: Could not open %s. Ensure the file exists.\n", filename);
+        fprintf(status_out, "Error: Could not open %s. Ensure the file exists.\n", filename);
         return NULL;
     }
 
-    TreeNode* root = NULL;
+    char (*commands)[MAX_CMD_LEN] = NULL;
+    int capacity = 0;
     char buffer[MAX_CMD_LEN];
     *count = 0;
 
-    while (fgets(buffer, sizeof(buffer), file) && *count < MAX_COMMANDS) {
+    while (fgets(buffer, sizeof(buffer), file)) {
         // Strip newline characters
         buffer[strcspn(buffer, "\r\n")] = 0;
-        
+
         if (strlen(buffer) > 0) {
-            root = insert_command(root, buffer);
+            if (*count == capacity) {
+                capacity = capacity ? capacity * 2 : 64;
+                char (*grown)[MAX_CMD_LEN] = realloc(commands, (size_t)capacity * MAX_CMD_LEN);
+                if (!grown) {
+                    fprintf(status_out, "Error: Out of memory loading %s.\n", filename);
+                    free(commands);
+                    fclose(file);
+                    return NULL;
+                }
+                commands = grown;
+            }
+            memset(commands[*count], 0, MAX_CMD_LEN);
+            strcpy(commands[*count], buffer);
             (*count)++;
         }
     }
-
     fclose(file);
-    printf(">> Successfully loaded %d approved commands.\n", *count);
-    return root;
+
+    CommandIndex* index = build_index(commands, *count);
+    if (!index) {
+        fprintf(status_out, "Error: Out of memory building command index.\n");
+        return NULL;
+    }
+    *count = index->count;
+    fprintf(status_out, ">> Successfully loaded %d approved commands.\n", *count);
+    return index;
+}
+
+// --- Verdict Cache ---
+
+uint32_t hash_command(const char* s) {
+    uint32_t h = 2166136261u; // FNV-1a
+    while (*s) h = (h ^ (unsigned char)*s++) * 16777619u;
+    return h;
+}
+
+void clear_shard(CacheShard* shard, unsigned long generation) {
+    memset(shard->buckets, -1, sizeof(shard->buckets));
+    shard->newest = shard->oldest = -1;
+    shard->used = 0;
+    shard->generation = generation;
+}
+
+void init_cache(VerdictCache* cache, unsigned long generation) {
+    for (int i = 0; i < CACHE_SHARDS; i++) {
+        CacheShard* shard = &cache->shards[i];
+        clear_shard(shard, generation);
+        shard->hits = shard->misses = 0;
+        pthread_mutex_init(&shard->lock, NULL);
+    }
+}
+
+void destroy_cache(VerdictCache* cache) {
+    for (int i = 0; i < CACHE_SHARDS; i++) pthread_mutex_destroy(&cache->shards[i].lock);
+}
+
+// Top hash bits pick the shard; the low bits pick the bucket within it
+CacheShard* cache_shard(VerdictCache* cache, uint32_t h) {
+    return &cache->shards[(h >> 28) & (CACHE_SHARDS - 1)];
 }
 
-// Log unrecognized commands
-void log_unrecognized(const char* cmd) {
-    FILE* file = fopen("unrecognized.log", "a");
-    if (file) {
-        fprintf(file, "REJECTED: %s\n", cmd);
-        fclose(file);
+void cache_unlink(CacheShard* shard, int e) {
+    CacheEntry* entry = &shard->entries[e];
+    if (entry->newer != -1) shard->entries[entry->newer].older = entry->older;
+    else shard->newest = entry->older;
+    if (entry->older != -1) shard->entries[entry->older].newer = entry->newer;
+    else shard->oldest = entry->newer;
+}
+
+void cache_push_newest(CacheShard* shard, int e) {
+    shard->entries[e].newer = -1;
+    shard->entries[e].older = shard->newest;
+    if (shard->newest != -1) shard->entries[shard->newest].newer = e;
+    shard->newest = e;
+    if (shard->oldest == -1) shard->oldest = e;
+}
+
+// Drop verdicts computed on an older command set. Caller holds the shard lock.
+// Returns 0 if 'index' is itself older than the shard's contents.
+int cache_sync(CacheShard* shard, const CommandIndex* index) {
+    if (index->generation > shard->generation) clear_shard(shard, index->generation);
+    return index->generation == shard->generation;
+}
+
+// Look up a cached verdict. Returns 1 and fills verdict/match on a hit.
+int cache_lookup(VerdictCache* cache, const CommandIndex* index, const char* cmd, Verdict* verdict, char* match) {
+    uint32_t h = hash_command(cmd);
+    CacheShard* shard = cache_shard(cache, h);
+    int found = 0;
+
+    pthread_mutex_lock(&shard->lock);
+    if (cache_sync(shard, index)) {
+        for (int e = shard->buckets[h & (SHARD_BUCKETS - 1)]; e != -1; e = shard->entries[e].bucket_next) {
+            CacheEntry* entry = &shard->entries[e];
+            if (strcmp(entry->input, cmd) != 0) continue;
+            *verdict = entry->verdict;
+            strcpy(match, entry->match);
+            cache_unlink(shard, e);
+            cache_push_newest(shard, e);
+            found = 1;
+            break;
+        }
+    }
+    if (found) shard->hits++;
+    else shard->misses++;
+    pthread_mutex_unlock(&shard->lock);
+    return found;
+}
+
+// Remember a verdict, evicting the shard's least recently used entry when full
+void cache_store(VerdictCache* cache, const CommandIndex* index, const char* cmd, Verdict verdict, const char* match) {
+    uint32_t h = hash_command(cmd);
+    CacheShard* shard = cache_shard(cache, h);
+    int bucket = (int)(h & (SHARD_BUCKETS - 1));
+
+    pthread_mutex_lock(&shard->lock);
+    if (!cache_sync(shard, index)) {
+        pthread_mutex_unlock(&shard->lock);
+        return;
+    }
+    for (int e = shard->buckets[bucket]; e != -1; e = shard->entries[e].bucket_next) {
+        if (strcmp(shard->entries[e].input, cmd) == 0) { // Another thread got here first
+            pthread_mutex_unlock(&shard->lock);
+            return;
+        }
+    }
+
+    int e;
+    if (shard->used < SHARD_SIZE) {
+        e = shard->used++;
     } else {
-        printf("Error: Could not write to log file.\n");
+        e = shard->oldest;
+        cache_unlink(shard, e);
+        int* link = &shard->buckets[hash_command(shard->entries[e].input) & (SHARD_BUCKETS - 1)];
+        while (*link != e) link = &shard->entries[*link].bucket_next;
+        *link = shard->entries[e].bucket_next;
+    }
+
+    CacheEntry* entry = &shard->entries[e];
+    strcpy(entry->input, cmd);
+    strcpy(entry->match, match);
+    entry->verdict = verdict;
+    entry->bucket_next = shard->buckets[bucket];
+    shard->buckets[bucket] = e;
+    cache_push_newest(shard, e);
+    pthread_mutex_unlock(&shard->lock);
+}
+
+// Totals across shards for the '!stats' command. Shards are cleared lazily
+// after a reload, so entries left over from an older index are not counted.
+void cache_stats(VerdictCache* cache, const CommandIndex* index, unsigned long* hits, unsigned long* misses, int* used) {
+    *hits = *misses = 0;
+    *used = 0;
+    for (int i = 0; i < CACHE_SHARDS; i++) {
+        CacheShard* shard = &cache->shards[i];
+        pthread_mutex_lock(&shard->lock);
+        *hits += shard->hits;
+        *misses += shard->misses;
+        if (shard->generation == index->generation) *used += shard->used;
+        pthread_mutex_unlock(&shard->lock);
     }
 }
 
+// --- Hot Reload (RCU-style snapshots) ---
+
+int file_changed(const struct stat* a, const struct stat* b) {
+    return a->st_ino != b->st_ino || a->st_size != b->st_size ||
+           a->st_mtim.tv_sec != b->st_mtim.tv_sec || a->st_mtim.tv_nsec != b->st_mtim.tv_nsec;
+}
+
+// Claim a hazard slot for the calling thread. Returns -1 if all are taken.
+int register_reader(CommandStore* store) {
+    int slot = atomic_fetch_add(&store->readers, 1);
+    if (slot >= MAX_READERS) {
+        fprintf(status_out, "Error: Too many index readers.\n");
+        return -1;
+    }
+    return slot;
+}
+
+// Pin the current snapshot. It stays valid until release_index.
+const CommandIndex* acquire_index(CommandStore* store, int reader) {
+    CommandIndex* index;
+    do {
+        index = atomic_load(&store->current);
+        atomic_store(&store->hazards[reader], index);
+        // Re-check: if a publish slipped in before the hazard was visible, retry
+    } while (index != atomic_load(&store->current));
+    return index;
+}
+
+void release_index(CommandStore* store, int reader) {
+    atomic_store_explicit(&store->hazards[reader], NULL, memory_order_release);
+}
+
+// Swap in a new index, then free the old one once no reader still holds it
+void publish_index(CommandStore* store, CommandIndex* index) {
+    index->generation = atomic_fetch_add(&store->generation, 1) + 1;
+    CommandIndex* old = atomic_exchange(&store->current, index);
+
+    int readers = atomic_load(&store->readers);
+    if (readers > MAX_READERS) readers = MAX_READERS;
+    for (int r = 0; r < readers; r++) {
+        while (atomic_load(&store->hazards[r]) == old) usleep(100);
+    }
+    free_index(old);
+}
+
+// Background thread: poll the command file and rebuild the index when it changes
+void* reload_loop(void* arg) {
+    CommandStore* store = (CommandStore*)arg;
+    struct stat now;
+
+    while (atomic_load(&store->running)) {
+        for (int waited = 0; waited < RELOAD_POLL_MS && atomic_load(&store->running); waited += 50) {
+            usleep(50 * 1000);
+        }
+        if (!atomic_load(&store->running)) break;
+        if (stat(store->filename, &now) != 0 || !file_changed(&now, &store->seen)) continue;
+
+        store->seen = now;
+        fprintf(status_out, "\n[RELOAD] %s changed, rebuilding command index...\n", store->filename);
+        int count = 0;
+        CommandIndex* index = load_approved_commands(store->filename, &count);
+        if (index == NULL || count == 0) {
+            fprintf(status_out, "[RELOAD] Keeping the previous command set.\n");
+            free_index(index);
+            continue;
+        }
+        publish_index(store, index);
+        fflush(status_out);
+    }
+    return NULL;
+}
+
+// Load the initial index and start watching the file
+int init_command_store(CommandStore* store, const char* filename) {
+    int count = 0;
+    store->filename = filename;
+    stat(filename, &store->seen);
+    CommandIndex* index = load_approved_commands(filename, &count);
+    if (index == NULL || count == 0) {
+        free_index(index);
+        return 0;
+    }
+
+    index->generation = 1;
+    atomic_init(&store->current, index);
+    for (int r = 0; r < MAX_READERS; r++) atomic_init(&store->hazards[r], NULL);
+    atomic_init(&store->readers, 0);
+    atomic_init(&store->generation, 1);
+    init_cache(&store->cache, 1);
+    atomic_init(&store->running, 1);
+    if (pthread_create(&store->thread, NULL, reload_loop, store) != 0) {
+        fprintf(status_out, "Warning: Could not start reload thread; command set is fixed.\n");
+        atomic_store(&store->running, 0);
+    }
+    return 1;
+}
+
+void shutdown_command_store(CommandStore* store, int thread_started) {
+    if (thread_started) {
+        atomic_store(&store->running, 0);
+        pthread_join(store->thread, NULL);
+    }
+    free_index(atomic_load(&store->current));
+    destroy_cache(&store->cache);
+}
+
+// --- Rejection Log ---
+
+// Record a rejected command for the writer. Never blocks on I/O.
+void log_unrecognized(RejectLog* log, const char* cmd) {
+    uint32_t h = hash_command(cmd) % (LOG_WINDOW_SIZE * 2);
+
+    pthread_mutex_lock(&log->lock);
+    while (log->slots[h] != -1 && strncmp(log->pending[log->slots[h]], cmd, MAX_CMD_LEN - 1) != 0) {
+        h = (h + 1) % (LOG_WINDOW_SIZE * 2);
+    }
+    if (log->slots[h] != -1) {
+        log->counts[log->slots[h]]++;
+    } else if (log->count == LOG_WINDOW_SIZE) {
+        log->dropped++;
+    } else {
+        char* slot = log->pending[log->count];
+        strncpy(slot, cmd, MAX_CMD_LEN - 1);
+        slot[MAX_CMD_LEN - 1] = '\0';
+        log->counts[log->count] = 1;
+        log->slots[h] = log->count++;
+    }
+    pthread_mutex_unlock(&log->lock);
+}
+
+// Write one window: one line per distinct command, repeats collapsed
+void write_rejections(FILE* file, char (*batch)[MAX_CMD_LEN], const int* counts, int n,
+                      unsigned long dropped) {
+    for (int i = 0; i < n; i++) {
+        if (counts[i] == 1) fprintf(file, "REJECTED: %s\n", batch[i]);
+        else fprintf(file, "REJECTED: %s (count %d)\n", batch[i], counts[i]);
+    }
+    if (dropped > 0) fprintf(file, "DROPPED: %lu rejections (log window full)\n", dropped);
+    fflush(file);
+}
+
+void* log_writer(void* arg) {
+    RejectLog* log = (RejectLog*)arg;
+    static char batch[LOG_WINDOW_SIZE][MAX_CMD_LEN];
+    static int counts[LOG_WINDOW_SIZE];
+
+    pthread_mutex_lock(&log->lock);
+    while (1) {
+        if (log->running) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += (long)LOG_FLUSH_MS * 1000000L;
+            deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+            deadline.tv_nsec %= 1000000000L;
+            pthread_cond_timedwait(&log->wake, &log->lock, &deadline);
+        }
+
+        // Take the whole window, then write it without holding the lock
+        int n = log->count;
+        memcpy(batch, log->pending, (size_t)n * MAX_CMD_LEN);
+        memcpy(counts, log->counts, (size_t)n * sizeof(int));
+        unsigned long dropped = log->dropped;
+        if (n > 0) memset(log->slots, -1, sizeof(log->slots));
+        log->count = 0;
+        log->dropped = 0;
+        int running = log->running;
+        pthread_mutex_unlock(&log->lock);
+
+        if (n > 0 || dropped > 0) write_rejections(log->file, batch, counts, n, dropped);
+        if (!running) return NULL;
+        pthread_mutex_lock(&log->lock);
+    }
+}
+
+// Open the log once and start the writer. On failure rejections are only counted.
+int init_reject_log(RejectLog* log, const char* filename) {
+    memset(log, 0, sizeof(RejectLog));
+    memset(log->slots, -1, sizeof(log->slots));
+    pthread_mutex_init(&log->lock, NULL);
+    pthread_cond_init(&log->wake, NULL);
+    log->file = fopen(filename, "a");
+    if (log->file == NULL) {
+        fprintf(status_out, "Error: Could not write to log file.\n");
+        return 0;
+    }
+    log->running = 1;
+    if (pthread_create(&log->thread, NULL, log_writer, log) != 0) {
+        fprintf(status_out, "Error: Could not start log writer.\n");
+        fclose(log->file);
+        log->file = NULL;
+        log->running = 0;
+        return 0;
+    }
+    return 1;
+}
+
+// Flush whatever is pending and close the log
+void shutdown_reject_log(RejectLog* log) {
+    if (log->file != NULL) {
+        pthread_mutex_lock(&log->lock);
+        log->running = 0;
+        pthread_cond_signal(&log->wake);
+        pthread_mutex_unlock(&log->lock);
+        pthread_join(log->thread, NULL);
+        fclose(log->file);
+    }
+    pthread_mutex_destroy(&log->lock);
+    pthread_cond_destroy(&log->wake);
+}
+
+// --- Batch Mode ---
+
+// Classify one command; best_match is filled in for VERDICT_SUGGEST
+Verdict check_command(const CommandIndex* index, VerdictCache* cache, const char* cmd, char* best_match) {
+    if (search_exact(index, cmd)) return VERDICT_OK;
+
+    Verdict verdict;
+    best_match[0] = '\0';
+    if (cache_lookup(cache, index, cmd, &verdict, best_match)) return verdict;
+
+    // A truncated command that only one approved command completes
+    int first;
+    if (strlen(cmd) >= MIN_PREFIX_LEN && find_prefix(index, cmd, &first) == 1) {
+        strcpy(best_match, index->commands[first]);
+        verdict = VERDICT_SUGGEST;
+    } else {
+        int min_dist = TYPO_THRESHOLD + 1;
+        find_closest_match(index, cmd, best_match, &min_dist);
+        verdict = min_dist <= TYPO_THRESHOLD ? VERDICT_SUGGEST : VERDICT_REJECT;
+    }
+    cache_store(cache, index, cmd, verdict, best_match);
+    return verdict;
+}
+
+// One worker's share of a chunk: a contiguous run of lines, verdicts written to
+// its own buffer so the chunk can be emitted in input order
+typedef struct {
+    CommandStore* store;
+    RejectLog* rejects;
+    int reader;
+    char** lines;
+    int count;
+    char* out;
+    size_t out_len;
+} BatchSlice;
+
+// Longest line write_verdict can produce: "SUGGEST:" + command + newline
+#define VERDICT_MAX (MAX_CMD_LEN + 9)
+
+// Check one command and append its verdict line to 'out'. Returns bytes written.
+size_t write_verdict(const CommandIndex* index, VerdictCache* cache, RejectLog* rejects, const char* cmd, char* out) {
+    char best_match[MAX_CMD_LEN];
+    // Longer than any approved command can be: reject without searching
+    Verdict v = strlen(cmd) >= MAX_CMD_LEN ? VERDICT_REJECT : check_command(index, cache, cmd, best_match);
+    if (v == VERDICT_OK) {
+        memcpy(out, "OK\n", 3);
+        return 3;
+    }
+    if (v == VERDICT_SUGGEST) {
+        size_t len = strlen(best_match);
+        memcpy(out, "SUGGEST:", 8);
+        memcpy(out + 8, best_match, len);
+        out[8 + len] = '\n';
+        return 9 + len;
+    }
+    memcpy(out, "REJECT\n", 7);
+    log_unrecognized(rejects, cmd);
+    return 7;
+}
+
+void* batch_worker(void* arg) {
+    BatchSlice* slice = (BatchSlice*)arg;
+    char* out = slice->out;
+
+    const CommandIndex* index = acquire_index(slice->store, slice->reader);
+    for (int i = 0; i < slice->count; i++) {
+        out += write_verdict(index, &slice->store->cache, slice->rejects, slice->lines[i], out);
+    }
+    release_index(slice->store, slice->reader);
+    slice->out_len = (size_t)(out - slice->out);
+    return NULL;
+}
+
+// Threads started once per batch run and handed one slice per chunk. The main
+// thread takes slice 0; the others wait at 'start' until the next chunk is split.
+// Chunks are split over however many threads actually started.
+typedef struct {
+    BatchSlice slices[MAX_WORKERS];
+    int threads;
+    int done;
+    pthread_mutex_t gate;          // Held until the barriers match the threads started
+    pthread_barrier_t start;
+    pthread_barrier_t finish;
+} BatchPool;
+
+typedef struct {
+    BatchPool* pool;
+    int t;
+} BatchThread;
+
+void* batch_thread(void* arg) {
+    BatchThread* self = (BatchThread*)arg;
+    BatchPool* pool = self->pool;
+    pthread_mutex_lock(&pool->gate);
+    pthread_mutex_unlock(&pool->gate);
+    while (1) {
+        pthread_barrier_wait(&pool->start);
+        if (pool->done) break;
+        batch_worker(&pool->slices[self->t]);
+        pthread_barrier_wait(&pool->finish);
+    }
+    return NULL;
+}
+
+// Authorize every non-empty line of 'in', one verdict per line on stdout
+int run_batch(CommandStore* store, RejectLog* rejects, FILE* in, int workers) {
+    static BatchPool pool;
+    BatchThread self[MAX_WORKERS];
+    pthread_t threads[MAX_WORKERS];
+    char* chunk = malloc(BATCH_CHUNK + 1);
+    int max_lines = BATCH_CHUNK / 2 + 1;
+    char** lines = malloc((size_t)max_lines * sizeof(char*));
+    int ok = (chunk != NULL && lines != NULL);
+
+    for (int w = 0; w < workers; w++) {
+        pool.slices[w].store = store;
+        pool.slices[w].rejects = rejects;
+        pool.slices[w].out = NULL;
+        pool.slices[w].reader = register_reader(store);
+        if (pool.slices[w].reader < 0) ok = 0;
+    }
+
+    pool.done = 0;
+    pool.threads = 1;
+    int pooled = ok && workers > 1;
+    if (pooled) {
+        pthread_mutex_init(&pool.gate, NULL);
+        pthread_mutex_lock(&pool.gate);
+        while (pool.threads < workers) {
+            self[pool.threads].pool = &pool;
+            self[pool.threads].t = pool.threads;
+            if (pthread_create(&threads[pool.threads], NULL, batch_thread, &self[pool.threads]) != 0) break;
+            pool.threads++;
+        }
+        pthread_barrier_init(&pool.start, NULL, (unsigned)pool.threads);
+        pthread_barrier_init(&pool.finish, NULL, (unsigned)pool.threads);
+        pthread_mutex_unlock(&pool.gate);
+    }
+
+    // Each worker only ever writes its own slice of a chunk's lines
+    int per_max = (max_lines + pool.threads - 1) / pool.threads;
+    for (int w = 0; ok && w < pool.threads; w++) {
+        pool.slices[w].out = malloc((size_t)per_max * VERDICT_MAX);
+        if (pool.slices[w].out == NULL) ok = 0;
+    }
+
+    size_t carry = 0;         // Partial line kept from the previous chunk
+    int skipping = 0;         // Inside an over-long line that did not fit a chunk
+    unsigned long total = 0;
+    while (ok) {
+        size_t got = fread(chunk + carry, 1, BATCH_CHUNK - carry, in);
+        size_t len = carry + got;
+        int at_eof = (got == 0);
+        if (len == 0) break;
+
+        // Split into NUL-terminated lines; the tail without a newline waits
+        int n = 0;
+        size_t start = 0;
+        for (size_t i = 0; i < len; i++) {
+            if (chunk[i] != '\n') continue;
+            chunk[i] = '\0';
+            if (i > start && chunk[i - 1] == '\r') chunk[i - 1] = '\0';
+            if (skipping) skipping = 0;
+            else if (chunk[start] != '\0') lines[n++] = chunk + start;
+            start = i + 1;
+        }
+        if (at_eof && start < len) {
+            chunk[len] = '\0';
+            if (chunk[len - 1] == '\r') chunk[len - 1] = '\0'; // Unterminated CRLF line
+            if (!skipping && chunk[start] != '\0') lines[n++] = chunk + start;
+            start = len;
+        }
+
+        int per = (n + pool.threads - 1) / pool.threads;
+        for (int w = 0; w < pool.threads; w++) {
+            int first = w * per;
+            pool.slices[w].lines = lines + first;
+            pool.slices[w].count = first >= n ? 0 : (n - first < per ? n - first : per);
+        }
+        if (pool.threads > 1) pthread_barrier_wait(&pool.start);
+        batch_worker(&pool.slices[0]);
+        if (pool.threads > 1) pthread_barrier_wait(&pool.finish);
+        for (int w = 0; w < pool.threads; w++) fwrite(pool.slices[w].out, 1, pool.slices[w].out_len, stdout);
+        total += (unsigned long)n;
+
+        if (at_eof) break;
+        carry = len - start;
+        if (carry == BATCH_CHUNK) {
+            // A single line fills the chunk: it cannot be a command, so reject it
+            // once and discard the rest of it
+            fputs("REJECT\n", stdout);
+            total++;
+            carry = 0;
+            skipping = 1;
+        } else {
+            memmove(chunk, chunk + start, carry);
+        }
+    }
+
+    if (pool.threads > 1) {
+        pool.done = 1;
+        pthread_barrier_wait(&pool.start);
+        for (int t = 1; t < pool.threads; t++) pthread_join(threads[t], NULL);
+    }
+    if (pooled) {
+        pthread_barrier_destroy(&pool.start);
+        pthread_barrier_destroy(&pool.finish);
+        pthread_mutex_destroy(&pool.gate);
+    }
+    if (!ok) {
+        fprintf(status_out, "Error: Out of memory starting batch mode.\n");
+    } else {
+        fflush(stdout);
+        fprintf(status_out, ">> Batch complete: %lu commands checked.\n", total);
+    }
+
+    for (int w = 0; w < workers; w++) {
+        if (pool.slices[w].reader >= 0) release_index(store, pool.slices[w].reader);
+        free(pool.slices[w].out);
+    }
+    free(chunk);
+    free(lines);
+    return ok;
+}
+
+// --- Daemon Mode ---
+// One epoll loop owns every socket; a fixed pool of workers does the lookups.
+// Clients may pipeline any number of newline-terminated commands. Each client
+// has at most one job in flight (all complete lines received so far), so its
+// replies come back in order without a reorder buffer.
+
+typedef struct Client {
+    int fd;
+    char in[CLIENT_BUF_SIZE];
+    size_t in_len;
+    char* out;                      // Replies not yet accepted by the socket
+    size_t out_len, out_sent, out_cap;
+    int busy;                       // A job for this client is with the pool
+    int eof;                        // Peer finished sending
+    int closed;                     // Socket gone; free once the job returns
+    struct Client* prev;
+    struct Client* next;
+} Client;
+
+// Dropped clients wait on 'dead' until the end of the wakeup, since later
+// events in the same epoll batch may still point at them
+typedef struct {
+    Client* live;
+    Client* dead;
+} ClientList;
+
+typedef struct DaemonJob {
+    Client* client;
+    char* text;                     // Complete lines copied out of client->in
+    size_t len;
+    char* out;
+    size_t out_len;
+    struct DaemonJob* next;
+} DaemonJob;
+
+typedef struct {
+    CommandStore* store;
+    RejectLog* rejects;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    DaemonJob* head;                // Pending jobs, FIFO
+    DaemonJob* tail;
+    DaemonJob* done;                // Finished jobs for the event loop
+    int done_fd;                    // eventfd: wakes the loop when 'done' fills
+    int running;
+    pthread_t threads[MAX_WORKERS];
+    int thread_count;
+} WorkerPool;
+
+volatile sig_atomic_t daemon_stop = 0;
+
+void handle_stop(int sig) {
+    (void)sig;
+    daemon_stop = 1;
+}
+
+void free_job(DaemonJob* job) {
+    free(job->text);
+    free(job->out);
+    free(job);
+}
+
+void* pool_worker(void* arg) {
+    WorkerPool* pool = (WorkerPool*)arg;
+    int reader = register_reader(pool->store);
+
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        while (pool->running && pool->head == NULL) pthread_cond_wait(&pool->ready, &pool->lock);
+        if (!pool->running) break;
+        DaemonJob* job = pool->head;
+        pool->head = job->next;
+        if (pool->head == NULL) pool->tail = NULL;
+        pthread_mutex_unlock(&pool->lock);
+
+        // Every line of the job is a command; the last one may lack its newline
+        size_t lines = 1;
+        for (size_t i = 0; i < job->len; i++) lines += (job->text[i] == '\n');
+        job->out = malloc(lines * VERDICT_MAX);
+        job->out_len = 0;
+        if (job->out != NULL && reader >= 0) {
+            const CommandIndex* index = acquire_index(pool->store, reader);
+            char* line = job->text;
+            char* end = job->text + job->len;
+            while (line < end) {
+                char* nl = memchr(line, '\n', (size_t)(end - line));
+                char* stop = nl ? nl : end;
+                *stop = '\0';
+                if (stop > line && stop[-1] == '\r') stop[-1] = '\0';
+                if (*line != '\0') {
+                    job->out_len += write_verdict(index, &pool->store->cache, pool->rejects, line,
+                                                  job->out + job->out_len);
+                }
+                line = stop + 1;
+            }
+            release_index(pool->store, reader);
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        job->next = pool->done;
+        pool->done = job;
+        uint64_t one = 1;
+        ssize_t sent = write(pool->done_fd, &one, sizeof(one));
+        (void)sent; // Only fails if the counter saturates, which cannot happen here
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+int start_pool(WorkerPool* pool, CommandStore* store, RejectLog* rejects, int workers) {
+    memset(pool, 0, sizeof(WorkerPool));
+    pool->store = store;
+    pool->rejects = rejects;
+    pool->running = 1;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->ready, NULL);
+    pool->done_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (pool->done_fd < 0) {
+        printf("Error: Could not create completion event.\n");
+        return 0;
+    }
+    for (int w = 0; w < workers; w++) {
+        if (pthread_create(&pool->threads[w], NULL, pool_worker, pool) != 0) break;
+        pool->thread_count++;
+    }
+    if (pool->thread_count == 0) {
+        printf("Error: Could not start worker threads.\n");
+        close(pool->done_fd);
+        return 0;
+    }
+    return 1;
+}
+
+// Stop the workers and free every job they did not hand back
+void stop_pool(WorkerPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->running = 0;
+    pthread_cond_broadcast(&pool->ready);
+    pthread_mutex_unlock(&pool->lock);
+    for (int w = 0; w < pool->thread_count; w++) pthread_join(pool->threads[w], NULL);
+
+    while (pool->head != NULL) {
+        DaemonJob* job = pool->head;
+        pool->head = job->next;
+        free_job(job);
+    }
+    while (pool->done != NULL) {
+        DaemonJob* job = pool->done;
+        pool->done = job->next;
+        free_job(job);
+    }
+    close(pool->done_fd);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->ready);
+}
+
+void drop_client(int epfd, ClientList* clients, Client* c) {
+    if (c->closed) return;
+    epoll_ctl(epfd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    c->closed = 1;
+
+    if (c->prev) c->prev->next = c->next;
+    else clients->live = c->next;
+    if (c->next) c->next->prev = c->prev;
+    c->prev = NULL;
+    c->next = clients->dead;
+    clients->dead = c;
+}
+
+// Free dropped clients, except those the pool still holds a job for
+void sweep_clients(ClientList* clients) {
+    Client** link = &clients->dead;
+    while (*link != NULL) {
+        Client* c = *link;
+        if (c->busy) {
+            link = &c->next;
+            continue;
+        }
+        *link = c->next;
+        free(c->out);
+        free(c);
+    }
+}
+
+// Write as much pending reply data as the socket takes. Returns 0 on error.
+int flush_client(Client* c) {
+    while (c->out_sent < c->out_len) {
+        ssize_t n = send(c->fd, c->out + c->out_sent, c->out_len - c->out_sent, MSG_NOSIGNAL);
+        if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK;
+        c->out_sent += (size_t)n;
+    }
+    c->out_len = c->out_sent = 0;
+    return 1;
+}
+
+int queue_reply(Client* c, const char* data, size_t len) {
+    if (c->out_len + len > c->out_cap) {
+        size_t cap = c->out_cap ? c->out_cap : 4096;
+        while (cap < c->out_len + len) cap *= 2;
+        char* grown = realloc(c->out, cap);
+        if (grown == NULL) return 0;
+        c->out = grown;
+        c->out_cap = cap;
+    }
+    memcpy(c->out + c->out_len, data, len);
+    c->out_len += len;
+    return 1;
+}
+
+// Hand the client's complete lines to the pool if it has none in flight and is
+// keeping up with its replies
+void dispatch_client(WorkerPool* pool, Client* c) {
+    if (c->busy || c->closed || c->out_len - c->out_sent >= CLIENT_BUF_SIZE) return;
+
+    size_t take = 0;
+    for (size_t i = c->in_len; i > 0; i--) {
+        if (c->in[i - 1] == '\n') {
+            take = i;
+            break;
+        }
+    }
+    if (c->eof) take = c->in_len; // A final unterminated line still counts
+    if (take == 0) return;
+
+    DaemonJob* job = malloc(sizeof(DaemonJob));
+    char* text = malloc(take + 1); // Room to terminate an unterminated last line
+    if (job == NULL || text == NULL) {
+        free(job);
+        free(text);
+        return; // Retried on the next event for this client
+    }
+    memcpy(text, c->in, take);
+    memmove(c->in, c->in + take, c->in_len - take);
+    c->in_len -= take;
+    job->client = c;
+    job->text = text;
+    job->len = take;
+    job->out = NULL;
+    job->next = NULL;
+    c->busy = 1;
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->tail) pool->tail->next = job;
+    else pool->head = job;
+    pool->tail = job;
+    pthread_cond_signal(&pool->ready);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// Re-arm epoll for what the client can make progress on. A client that finished
+// sending is closed once its last reply is out.
+void update_client(int epfd, ClientList* clients, Client* c) {
+    if (c->closed) return;
+    int pending_out = c->out_len > c->out_sent;
+    if (c->eof && !c->busy && c->in_len == 0 && !pending_out) {
+        drop_client(epfd, clients, c);
+        return;
+    }
+    struct epoll_event ev;
+    ev.events = 0;
+    if (!c->eof && c->in_len < CLIENT_BUF_SIZE) ev.events |= EPOLLIN;
+    if (pending_out) ev.events |= EPOLLOUT;
+    ev.data.ptr = c;
+    epoll_ctl(epfd, EPOLL_CTL_MOD, c->fd, &ev);
+}
+
+void read_client(int epfd, ClientList* clients, Client* c) {
+    while (c->in_len < CLIENT_BUF_SIZE) {
+        ssize_t n = recv(c->fd, c->in + c->in_len, CLIENT_BUF_SIZE - c->in_len, 0);
+        if (n > 0) {
+            c->in_len += (size_t)n;
+        } else if (n == 0) {
+            c->eof = 1;
+            break;
+        } else {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) drop_client(epfd, clients, c);
+            return;
+        }
+    }
+    // A full buffer without a newline cannot hold a command: protocol error
+    if (c->in_len == CLIENT_BUF_SIZE && memchr(c->in, '\n', c->in_len) == NULL) {
+        fprintf(status_out, "Warning: Dropping client sending an over-long line.\n");
+        drop_client(epfd, clients, c);
+    }
+}
+
+void accept_clients(int epfd, int listen_fd, ClientList* clients) {
+    while (1) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) return;
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        Client* c = calloc(1, sizeof(Client));
+        if (c == NULL) {
+            close(fd);
+            continue;
+        }
+        c->fd = fd;
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.ptr = c;
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            close(fd);
+            free(c);
+            continue;
+        }
+        c->next = clients->live;
+        if (clients->live) clients->live->prev = c;
+        clients->live = c;
+    }
+}
+
+// Move finished jobs' replies onto their clients' output
+void collect_done(int epfd, WorkerPool* pool, ClientList* clients) {
+    uint64_t ticks;
+    ssize_t got = read(pool->done_fd, &ticks, sizeof(ticks));
+    (void)got; // EAGAIN just means another wakeup already drained it
+    pthread_mutex_lock(&pool->lock);
+    DaemonJob* job = pool->done;
+    pool->done = NULL;
+    pthread_mutex_unlock(&pool->lock);
+
+    while (job != NULL) {
+        DaemonJob* next = job->next;
+        Client* c = job->client;
+        c->busy = 0;
+        if (c->closed) {
+            // Already on the dead list; the sweep frees it now
+        } else if (job->out == NULL || !queue_reply(c, job->out, job->out_len) || !flush_client(c)) {
+            drop_client(epfd, clients, c);
+        } else {
+            dispatch_client(pool, c);
+            update_client(epfd, clients, c);
+        }
+        free_job(job);
+        job = next;
+    }
+}
+
+// Remove a socket file left behind by a daemon that is gone. Refuses (returns 0)
+// when a live daemon still answers on it or the path is not a socket at all.
+int clear_stale_socket(const char* path, const struct sockaddr_un* addr) {
+    struct stat st;
+    if (lstat(path, &st) != 0) return errno == ENOENT; // Nothing there to clear
+    if (!S_ISSOCK(st.st_mode)) {
+        printf("Error: %s exists and is not a socket.\n", path);
+        return 0;
+    }
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probe < 0) {
+        printf("Error: Could not create socket.\n");
+        return 0;
+    }
+    int live = connect(probe, (const struct sockaddr*)addr, sizeof(*addr)) == 0;
+    close(probe);
+    if (live) {
+        printf("Error: Another daemon is already listening on %s.\n", path);
+        return 0;
+    }
+    unlink(path);
+    return 1;
+}
+
+int open_listener(const char* path) {
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        printf("Error: Socket path too long.\n");
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        printf("Error: Could not create socket.\n");
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    if (!clear_stale_socket(path, &addr)) {
+        close(fd);
+        return -1;
+    }
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        printf("Error: Could not listen on %s.\n", path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Serve authorization requests on a Unix socket until SIGINT/SIGTERM
+int run_daemon(CommandStore* store, RejectLog* rejects, const char* path, int workers) {
+    WorkerPool pool;
+    ClientList clients = {NULL, NULL};
+
+    int listen_fd = open_listener(path);
+    if (listen_fd < 0) return 0;
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0 || !start_pool(&pool, store, rejects, workers)) {
+        if (epfd >= 0) close(epfd);
+        close(listen_fd);
+        unlink(path);
+        return 0;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_stop; // No SA_RESTART: epoll_wait must return
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL; // The listener
+    epoll_ctl(epfd, EPOLL_CTL_ADD, listen_fd, &ev);
+    ev.data.ptr = &pool;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, pool.done_fd, &ev);
+
+    printf(">> Listening on %s with %d workers.\n", path, pool.thread_count);
+    fflush(stdout);
+
+    struct epoll_event events[MAX_EVENTS];
+    while (!daemon_stop) {
+        int n = epoll_wait(epfd, events, MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            printf("Error: epoll_wait failed.\n");
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            void* tag = events[i].data.ptr;
+            if (tag == NULL) {
+                accept_clients(epfd, listen_fd, &clients);
+            } else if (tag == &pool) {
+                collect_done(epfd, &pool, &clients);
+            } else {
+                Client* c = (Client*)tag;
+                if (c->closed) continue; // Dropped earlier in this wakeup
+                if (events[i].events & (EPOLLERR | EPOLLHUP) && !(events[i].events & EPOLLIN)) {
+                    drop_client(epfd, &clients, c);
+                    continue;
+                }
+                if (events[i].events & EPOLLOUT && !flush_client(c)) {
+                    drop_client(epfd, &clients, c);
+                    continue;
+                }
+                if (events[i].events & EPOLLIN) {
+                    read_client(epfd, &clients, c);
+                    if (c->closed) continue;
+                }
+                dispatch_client(&pool, c);
+                update_client(epfd, &clients, c);
+            }
+        }
+        sweep_clients(&clients);
+    }
+
+    printf("\nShutting down daemon... cleaning memory.\n");
+    stop_pool(&pool); // Frees every outstanding job, so no client is busy after this
+    while (clients.live != NULL) drop_client(epfd, &clients, clients.live);
+    for (Client* c = clients.dead; c != NULL; c = c->next) c->busy = 0;
+    sweep_clients(&clients);
+    close(epfd);
+    close(listen_fd);
+    unlink(path);
+    return 1;
+}
+
 // --- Main Interface ---
 
-int main() {
-    TreeNode* root = NULL;
-    int command_count = 0;
-    
-    printf("--- Industrial Control Terminal Initialization ---\n");
-    root = load_approved_commands("approved_commands.txt", &command_count);
-    
-    if (root == NULL) {
-        printf("System halted. Missing configuration.\n");
+int main(int argc, char* argv[]) {
+    static CommandStore store;
+    static RejectLog rejects;
+    int batch = 0;
+    int workers = 0; // Default: 1 in batch mode, DAEMON_WORKERS as a daemon
+    const char* input_path = NULL;
+    const char* socket_path = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "bi:w:d:")) != -1) {
+        switch (opt) {
+            case 'b': // Read commands from stdin, print one verdict per line
+                batch = 1;
+                break;
+            case 'i': // Batch mode reading from a file
+                input_path = optarg;
+                batch = 1;
+                break;
+            case 'w':
+                workers = atoi(optarg);
+                if (workers < 1) {
+                    printf("Error: Workers must be between 1 and %d.\n", MAX_WORKERS);
+                    return 1;
+                }
+                break;
+            case 'd': // Serve clients on a Unix socket
+                socket_path = optarg;
+                break;
+            default:
+                printf("Usage: %s [-b | -i command_file | -d socket_path] [-w workers]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (workers == 0) workers = socket_path ? DAEMON_WORKERS : 1;
+    if (workers > MAX_WORKERS) {
+        printf("Error: Workers must be between 1 and %d.\n", MAX_WORKERS);
+        return 1;
+    }
+    status_out = batch ? stderr : stdout;
+
+    fprintf(status_out, "--- Industrial Control Terminal Initialization ---\n");
+    if (!init_command_store(&store, COMMANDS_FILE)) {
+        fprintf(status_out, "System halted. Missing configuration.\n");
         return 1;
     }
+    int reloading = atomic_load(&store.running);
+    init_reject_log(&rejects, LOG_FILE);
+
+    if (batch) {
+        FILE* in = input_path ? fopen(input_path, "r") : stdin;
+        int ok = 0;
+        if (in == NULL) {
+            fprintf(status_out, "Error: Could not open %s.\n", input_path);
+        } else {
+            ok = run_batch(&store, &rejects, in, workers);
+            if (in != stdin) fclose(in);
+        }
+        shutdown_reject_log(&rejects);
+        shutdown_command_store(&store, reloading);
+        return ok ? 0 : 1;
+    }
+    if (socket_path) {
+        int ok = run_daemon(&store, &rejects, socket_path, workers);
+        shutdown_reject_log(&rejects);
+        shutdown_command_store(&store, reloading);
+        return ok ? 0 : 1;
+    }
+
+    int reader = register_reader(&store);
 
     char input[MAX_CMD_LEN];
     
@@ -169,28 +1655,57 @@ int main() {
 
         if (strlen(input) == 0) continue;
 
-        // 1. Check for Exact Match
-        if (search_exact(root, input)) {
-            printf("[SUCCESS] Command '%s' Executed.\n", input);
+        // Pin one snapshot for the whole check, even if a reload lands meanwhile
+        const CommandIndex* index = acquire_index(&store, reader);
+
+        // '!stats' reports how often repeated typos were answered from the cache
+        if (strcmp(input, "!stats") == 0) {
+            unsigned long hits, misses;
+            int used;
+            cache_stats(&store.cache, index, &hits, &misses, &used);
+            unsigned long lookups = hits + misses;
+            printf("[STATS] Command set generation %lu, %d commands.\n", index->generation, index->count);
+            printf("[STATS] Verdict cache: %lu hits, %lu misses (%.1f%% hit rate), %d/%d entries.\n",
+                   hits, misses, lookups ? 100.0 * (double)hits / (double)lookups : 0.0, used, CACHE_SIZE);
+            release_index(&store, reader);
             continue;
         }
 
-        // 2. Exact match failed. Check for Minor Typo
+        // '?PREFIX' lists the approved commands starting with PREFIX
+        if (input[0] == '?') {
+            int first = 0;
+            int matches = find_prefix(index, input + 1, &first);
+            if (matches == 0) {
+                printf("[COMPLETE] No approved command starts with '%s'.\n", input + 1);
+            } else {
+                printf("[COMPLETE] %d command(s) start with '%s':\n", matches, input + 1);
+                for (int i = 0; i < matches && i < COMPLETE_SHOW; i++) {
+                    printf("  %s\n", index->commands[first + i]);
+                }
+                if (matches > COMPLETE_SHOW) printf("  ... and %d more\n", matches - COMPLETE_SHOW);
+            }
+            release_index(&store, reader);
+            continue;
+        }
+
+        // Exact match first, then the closest command within the typo threshold
         char best_match[MAX_CMD_LEN] = "";
-        int min_dist = 9999; // Initialize with a high number
-        
-        find_closest_match(root, input, best_match, &min_dist);
+        Verdict verdict = check_command(index, &store.cache, input, best_match);
+        release_index(&store, reader);
 
-        if (min_dist <= TYPO_THRESHOLD) {
+        if (verdict == VERDICT_OK) {
+            printf("[SUCCESS] Command '%s' Executed.\n", input);
+        } else if (verdict == VERDICT_SUGGEST) {
             printf("[ERROR] Unrecognized command. Did you mean '%s'?\n", best_match);
         } else {
-            // 3. Completely unrecognized
+            // Completely unrecognized
             printf("[SECURITY ALERT] Unrecognized command rejected and logged.\n");
-            log_unrecognized(input);
+            log_unrecognized(&rejects, input);
         }
     }
 
     // Cleanup
-    free_tree(root);
+    shutdown_reject_log(&rejects);
+    shutdown_command_store(&store, reloading);
     return 0;
 }
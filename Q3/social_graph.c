@@ -1,51 +1,555 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-#define MAX_USERS 20
 #define ID_LEN 10
+#define INITIAL_USERS 16
+#define MATRIX_SHOW 40  // Larger graphs are too wide to print as a matrix
+#define COMPACT_MIN 64  // Tombstones tolerated before compaction is considered
+#define COMPACT_RATIO 4 // ...and compaction runs once they are 1/COMPACT_RATIO of all slots
+#define BITSET_MIN_DEGREE 64 // Rows below this degree always stay sorted lists
+#define MAX_THREADS 16       // Worker threads for BFS and bulk import
+#define BFS_PARALLEL_MIN 4096 // Smaller graphs are searched on one thread
+#define BFS_CHUNK_WORDS 16    // Frontier words claimed per grab (1024 users)
+#define BFS_ALPHA 14          // Go bottom-up once frontier edges > unexplored / ALPHA
+#define BFS_BETA 24           // Back to top-down once frontier < users / BETA
+#define REACH_SHOW 20         // Users listed per hop by the k-hop query
+#define LOAD_PARALLEL_MIN (1 << 20) // Edge files below this many bytes parse on one thread
+#define PATH_LEN 256
+#define SNAPSHOT_MAGIC 0x50534753u // "SGSP"
+#define SNAPSHOT_VERSION 1
+#define RANK_DAMPING 0.85
+#define RANK_TOLERANCE 1e-6 // Full iteration stops once the mean change per user is below this
+#define RANK_MAX_ITER 100
+// Residuals up to this size are left unpushed: the per-user change at which
+// a full iteration stops, so both paths settle to the same accuracy
+#define RANK_EPSILON RANK_TOLERANCE
+#define RANK_PUSH_RATIO 8   // Iterate instead of pushing once 1/RATIO of users are queued
+#define RANK_CHUNK 1024     // Users claimed per grab by a PageRank thread
 
+// Hash slot markers
+#define SLOT_EMPTY -1
+#define SLOT_DELETED -2
+
+// User slot states. A removed user's slot stays a tombstone while other lists
+// may still name it; compaction purges those references and frees the slot.
+#define USER_FREE 0
+#define USER_LIVE 1
+#define USER_TOMBSTONE 2
+
+// Set of user indices. Sparse rows are sorted lists; a row switches to a bitset
+// over all slots once that is smaller (degree above num_slots / 32) and back
+// when it falls under half that. A list whose items point into a loaded
+// snapshot has capacity 0 and is copied to the heap on its first change.
+typedef struct {
+    int* items;         // List mode: sorted ascending (bits == NULL)
+    int capacity;
+    uint64_t* bits;     // Bitset mode: bit v set if v is a member
+    int words;
+    int count;          // Members in either mode
+} AdjSet;
+
+// PageRank scores, kept in step with edge updates once first computed.
+// Unnormalised: score[v] = (1 - d) + d * sum(score[u] / out_degree[u]) over
+// in-neighbours u. Someone nobody interacts with scores 1 - d, and the mean
+// stays at most 1 (dangling users pass nothing on). Updates maintain
+// residual = (1 - d) + d * P * score - score, which pushing drives back to 0.
 typedef struct {
-    char user_ids[MAX_USERS][ID_LEN];
-    int adj_matrix[MAX_USERS][MAX_USERS];
-    int num_users;
+    double* score;      // NULL until first computed
+    double* residual;   // Signed change not yet pushed
+    int* degree;        // Live out-degree per slot
+    int* queue;         // FIFO ring (capacity slots) of users whose residual may exceed RANK_EPSILON
+    unsigned char* queued;
+    int queue_head;
+    int queue_len;
+    long edges;         // Live interactions: one full iteration visits this many
+} Ranks;
+
+// Sparse directed graph: per-user out/in adjacency sets instead of a V x V matrix,
+// and an open-addressed hash from user ID to index. Lists may still name
+// tombstoned users; every reader skips them.
+typedef struct {
+    char (*user_ids)[ID_LEN];
+    AdjSet* out;       // out[u]: users u interacts with
+    AdjSet* in;        // in[v]: users who interact with v
+    unsigned char* state; // USER_* per slot
+    uint64_t* live_bits;  // Bit per slot, set while the user is live
+    int num_users;      // Live users
+    int num_slots;      // Slots ever used; indices are < num_slots
+    int num_dead;       // Tombstones awaiting compaction
+    int* free_slots;    // Compacted slots ready for reuse
+    int free_count;
+    int capacity;
+    int* id_slots;      // Hash table of user indices (power-of-two size)
+    int slot_count;
+    int slot_used;      // Occupied plus deleted slots
+    void* snapshot;     // Mapped snapshot file that borrowed rows point into
+    size_t snapshot_size;
+    Ranks ranks;
 } SocialGraph;
 
 // --- Graph Initialization ---
-void init_graph(SocialGraph* g) {
+int init_graph(SocialGraph* g) {
     g->num_users = 0;
-    for (int i = 0; i < MAX_USERS; i++) {
-        for (int j = 0; j < MAX_USERS; j++) {
-            g->adj_matrix[i][j] = 0;
-        }
+    g->num_slots = 0;
+    g->num_dead = 0;
+    g->free_count = 0;
+    g->snapshot = NULL;
+    g->snapshot_size = 0;
+    memset(&g->ranks, 0, sizeof(Ranks));
+    g->capacity = INITIAL_USERS;
+    g->user_ids = malloc((size_t)g->capacity * ID_LEN);
+    g->out = calloc((size_t)g->capacity, sizeof(AdjSet));
+    g->in = calloc((size_t)g->capacity, sizeof(AdjSet));
+    g->state = calloc((size_t)g->capacity, 1);
+    g->live_bits = calloc((size_t)g->capacity / 64 + 1, sizeof(uint64_t));
+    g->free_slots = malloc(sizeof(int) * (size_t)g->capacity);
+    g->slot_count = INITIAL_USERS * 2;
+    g->slot_used = 0;
+    g->id_slots = malloc(sizeof(int) * (size_t)g->slot_count);
+    if (!g->user_ids || !g->out || !g->in || !g->state || !g->live_bits || !g->free_slots || !g->id_slots) {
+        printf("Error: Out of memory initializing graph.\n");
+        return 0;
+    }
+    memset(g->id_slots, -1, sizeof(int) * (size_t)g->slot_count); // SLOT_EMPTY
+    return 1;
+}
+
+// Items still live in the snapshot mapping and must not be written or freed
+int adj_borrowed(const AdjSet* set) {
+    return set->items && set->capacity == 0;
+}
+
+void adj_free(AdjSet* set) {
+    if (!adj_borrowed(set)) free(set->items);
+    free(set->bits);
+    memset(set, 0, sizeof(AdjSet));
+}
+
+void rank_free(Ranks* r) {
+    free(r->score);
+    free(r->residual);
+    free(r->degree);
+    free(r->queue);
+    free(r->queued);
+    memset(r, 0, sizeof(Ranks));
+}
+
+void free_graph(SocialGraph* g) {
+    for (int i = 0; i < g->num_slots; i++) {
+        adj_free(&g->out[i]);
+        adj_free(&g->in[i]);
+    }
+    free(g->user_ids);
+    free(g->out);
+    free(g->in);
+    free(g->state);
+    free(g->live_bits);
+    free(g->free_slots);
+    free(g->id_slots);
+    if (g->snapshot) munmap(g->snapshot, g->snapshot_size);
+    rank_free(&g->ranks);
+}
+
+int user_live(const SocialGraph* g, int idx) {
+    return g->state[idx] == USER_LIVE;
+}
+
+// --- Helper: ID Hash Index ---
+
+uint32_t hash_id(const char* id) {
+    uint32_t h = 2166136261u; // FNV-1a
+    while (*id) h = (h ^ (unsigned char)*id++) * 16777619u;
+    return h;
+}
+
+// Slot holding 'id', or -1. Probing is linear; deleted slots do not end a probe.
+int find_slot(SocialGraph* g, const char* id) {
+    uint32_t mask = (uint32_t)g->slot_count - 1;
+    for (uint32_t s = hash_id(id) & mask;; s = (s + 1) & mask) {
+        int idx = g->id_slots[s];
+        if (idx == SLOT_EMPTY) return -1;
+        if (idx >= 0 && strcmp(g->user_ids[idx], id) == 0) return (int)s;
+    }
+}
+
+// Place index 'idx' (whose ID is already stored) in the first free slot
+void insert_slot(SocialGraph* g, int idx) {
+    uint32_t mask = (uint32_t)g->slot_count - 1;
+    uint32_t s = hash_id(g->user_ids[idx]) & mask;
+    while (g->id_slots[s] >= 0) s = (s + 1) & mask;
+    if (g->id_slots[s] == SLOT_EMPTY) g->slot_used++;
+    g->id_slots[s] = idx;
+}
+
+// Rebuild the table at a size that keeps it at most half full
+int rehash_ids(SocialGraph* g) {
+    int size = 16;
+    while (size < 4 * (g->num_users + 1)) size *= 2;
+    int* slots = malloc(sizeof(int) * (size_t)size);
+    if (!slots) return 0;
+    free(g->id_slots);
+    g->id_slots = slots;
+    g->slot_count = size;
+    g->slot_used = 0;
+    memset(slots, -1, sizeof(int) * (size_t)size);
+    for (int i = 0; i < g->num_slots; i++) {
+        if (user_live(g, i)) insert_slot(g, i);
     }
+    return 1;
 }
 
 // --- Helper: Get Index from ID ---
 int get_user_index(SocialGraph* g, const char* id) {
-    for (int i = 0; i < g->num_users; i++) {
-        if (strcmp(g->user_ids[i], id) == 0) {
-            return i;
+    int s = find_slot(g, id);
+    return s == -1 ? -1 : g->id_slots[s]; // -1: Not found
+}
+
+// --- Helper: Adjacency Sets ---
+
+// Position of v in a list-mode set, or where it would be inserted
+int adj_position(const AdjSet* set, int v) {
+    int lo = 0, hi = set->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (set->items[mid] < v) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+int adj_contains(const AdjSet* set, int v) {
+    if (set->bits) return v / 64 < set->words && ((set->bits[v / 64] >> (v % 64)) & 1);
+    int pos = adj_position(set, v);
+    return pos < set->count && set->items[pos] == v;
+}
+
+// Next member at or after *cursor (start from 0), ascending; -1 when done
+int adj_next(const AdjSet* set, int* cursor) {
+    if (!set->bits) return *cursor < set->count ? set->items[(*cursor)++] : -1;
+    int w = *cursor / 64;
+    if (w >= set->words) return -1;
+    uint64_t word = set->bits[w] & (~0ULL << (*cursor % 64));
+    while (word == 0) {
+        if (++w == set->words) {
+            *cursor = w * 64;
+            return -1;
+        }
+        word = set->bits[w];
+    }
+    int v = w * 64 + __builtin_ctzll(word);
+    *cursor = v + 1;
+    return v;
+}
+
+// Switch to a bitset covering every slot. Returns 0 (set unchanged) on failure.
+int adj_to_bitset(AdjSet* set, int universe) {
+    int words = (universe + 63) / 64;
+    uint64_t* bits = calloc((size_t)words, sizeof(uint64_t));
+    if (!bits) return 0;
+    for (int i = 0; i < set->count; i++) bits[set->items[i] / 64] |= 1ULL << (set->items[i] % 64);
+    if (!adj_borrowed(set)) free(set->items);
+    set->items = NULL;
+    set->capacity = 0;
+    set->bits = bits;
+    set->words = words;
+    return 1;
+}
+
+int adj_to_list(AdjSet* set) {
+    int capacity = set->count > 4 ? set->count : 4;
+    int* items = malloc(sizeof(int) * (size_t)capacity);
+    if (!items) return 0;
+    int n = 0;
+    for (int c = 0, v; (v = adj_next(set, &c)) != -1;) items[n++] = v;
+    free(set->bits);
+    set->bits = NULL;
+    set->words = 0;
+    set->items = items;
+    set->capacity = capacity;
+    return 1;
+}
+
+// Copy a borrowed list to the heap before it is modified
+int adj_own(AdjSet* set) {
+    int capacity = set->count > 4 ? set->count : 4;
+    int* items = malloc(sizeof(int) * (size_t)capacity);
+    if (!items) return 0;
+    memcpy(items, set->items, sizeof(int) * (size_t)set->count);
+    set->items = items;
+    set->capacity = capacity;
+    return 1;
+}
+
+// Pick the smaller representation for the set's current degree
+void adj_rebalance(const SocialGraph* g, AdjSet* set) {
+    if (!set->bits && set->count >= BITSET_MIN_DEGREE && set->count * 32 > g->num_slots) {
+        adj_to_bitset(set, g->num_slots); // On failure the list still works
+    } else if (set->bits && set->count * 64 < g->num_slots) {
+        adj_to_list(set);
+    }
+}
+
+// Returns 1 if added, 0 if already present, -1 on allocation failure
+int adj_insert(const SocialGraph* g, AdjSet* set, int v) {
+    if (set->bits) {
+        if (v / 64 >= set->words) { // Slots were added since the bitset was sized
+            int words = (g->num_slots + 63) / 64;
+            uint64_t* grown = realloc(set->bits, sizeof(uint64_t) * (size_t)words);
+            if (!grown) return -1;
+            memset(grown + set->words, 0, sizeof(uint64_t) * (size_t)(words - set->words));
+            set->bits = grown;
+            set->words = words;
         }
+        uint64_t bit = 1ULL << (v % 64);
+        if (set->bits[v / 64] & bit) return 0;
+        set->bits[v / 64] |= bit;
+        set->count++;
+        return 1;
+    }
+
+    int pos = adj_position(set, v);
+    if (pos < set->count && set->items[pos] == v) return 0;
+    if (adj_borrowed(set) && !adj_own(set)) return -1;
+    if (set->count == set->capacity) {
+        int capacity = set->capacity ? set->capacity * 2 : 4;
+        int* grown = realloc(set->items, sizeof(int) * (size_t)capacity);
+        if (!grown) return -1;
+        set->items = grown;
+        set->capacity = capacity;
     }
-    return -1; // Not found
+    memmove(&set->items[pos + 1], &set->items[pos], sizeof(int) * (size_t)(set->count - pos));
+    set->items[pos] = v;
+    set->count++;
+    adj_rebalance(g, set);
+    return 1;
+}
+
+// Returns 1 if removed, 0 if it was not there
+int adj_remove(const SocialGraph* g, AdjSet* set, int v) {
+    if (!adj_contains(set, v)) return 0;
+    if (adj_borrowed(set) && !adj_own(set)) return 0;
+    if (set->bits) {
+        set->bits[v / 64] &= ~(1ULL << (v % 64));
+    } else {
+        int pos = adj_position(set, v);
+        memmove(&set->items[pos], &set->items[pos + 1], sizeof(int) * (size_t)(set->count - pos - 1));
+    }
+    set->count--;
+    adj_rebalance(g, set);
+    return 1;
+}
+
+// Drop members that are no longer live
+void adj_purge(const SocialGraph* g, AdjSet* set) {
+    if (set->bits) {
+        set->count = 0;
+        for (int w = 0; w < set->words; w++) {
+            set->bits[w] &= g->live_bits[w];
+            set->count += __builtin_popcountll(set->bits[w]);
+        }
+    } else {
+        if (adj_borrowed(set) && !adj_own(set)) return; // Stale references are skipped anyway
+        int kept = 0;
+        for (int i = 0; i < set->count; i++) {
+            if (user_live(g, set->items[i])) set->items[kept++] = set->items[i];
+        }
+        set->count = kept;
+    }
+    adj_rebalance(g, set);
+}
+
+// --- Compaction ---
+
+// Purge every reference to a tombstone, then hand the tombstoned slots out for
+// reuse. O(V + E), run only once tombstones make up a fixed share of the slots.
+void compact_graph(SocialGraph* g) {
+    for (int i = 0; i < g->num_slots; i++) {
+        if (!user_live(g, i)) continue;
+        adj_purge(g, &g->out[i]);
+        adj_purge(g, &g->in[i]);
+    }
+    for (int i = 0; i < g->num_slots; i++) {
+        if (g->state[i] == USER_TOMBSTONE) {
+            g->state[i] = USER_FREE;
+            g->free_slots[g->free_count++] = i;
+        }
+    }
+    g->num_dead = 0;
+}
+
+// --- PageRank Maintenance ---
+
+// Live members of a set; lists only overcount while tombstones are pending
+int live_count(const SocialGraph* g, const AdjSet* set) {
+    if (g->num_dead == 0) return set->count;
+    int n = 0;
+    for (int c = 0, v; (v = adj_next(set, &c)) != -1;) n += user_live(g, v);
+    return n;
+}
+
+void rank_add_residual(SocialGraph* g, int v, double delta) {
+    Ranks* r = &g->ranks;
+    r->residual[v] += delta;
+    if (!r->queued[v] && fabs(r->residual[v]) > RANK_EPSILON) {
+        r->queued[v] = 1;
+        r->queue[(r->queue_head + r->queue_len++) % g->capacity] = v;
+    }
+}
+
+// Edge u -> w was added. Rescaling score[u] by (k + 1) / k keeps what u's
+// other k targets receive unchanged, so only w and u need correcting: O(1).
+void rank_edge_added(SocialGraph* g, int u, int w) {
+    Ranks* r = &g->ranks;
+    if (!r->score) return;
+    int k = r->degree[u]++;
+    r->edges++;
+    if (k == 0) {
+        rank_add_residual(g, w, RANK_DAMPING * r->score[u]); // u was dangling
+        return;
+    }
+    double share = r->score[u] / k;
+    r->score[u] += share;
+    rank_add_residual(g, u, -share);
+    rank_add_residual(g, w, RANK_DAMPING * share);
+}
+
+// Edge u -> w was removed: the same rescaling by (k - 1) / k
+void rank_edge_removed(SocialGraph* g, int u, int w) {
+    Ranks* r = &g->ranks;
+    if (!r->score || r->degree[u] == 0) return;
+    int k = r->degree[u]--;
+    r->edges--;
+    double share = r->score[u] / k;
+    if (k > 1) {
+        r->score[u] -= share;
+        rank_add_residual(g, u, share);
+    }
+    rank_add_residual(g, w, -RANK_DAMPING * share);
+}
+
+// A new user starts at the score of someone nobody interacts with
+void rank_user_added(SocialGraph* g, int idx) {
+    Ranks* r = &g->ranks;
+    if (!r->score) return;
+    r->score[idx] = 1.0 - RANK_DAMPING;
+    r->residual[idx] = 0;
+    r->degree[idx] = 0;
+}
+
+// Called while 'k' is still live: withdraw everything k sent and received
+void rank_user_removed(SocialGraph* g, int k) {
+    Ranks* r = &g->ranks;
+    if (!r->score) return;
+    for (int c = 0, u; (u = adj_next(&g->in[k], &c)) != -1;) {
+        if (u != k && user_live(g, u)) rank_edge_removed(g, u, k);
+    }
+    if (r->degree[k] > 0) {
+        double share = RANK_DAMPING * r->score[k] / r->degree[k];
+        for (int c = 0, v; (v = adj_next(&g->out[k], &c)) != -1;) {
+            if (v != k && user_live(g, v)) rank_add_residual(g, v, -share);
+        }
+    }
+    r->score[k] = r->residual[k] = 0;
+    r->edges -= r->degree[k];
+    r->degree[k] = 0;
 }
 
 // --- Dynamic Updates ---
 
+// Grow every per-slot array to hold 'capacity' users. Returns 0 if out of memory.
+int grow_users(SocialGraph* g, int capacity) {
+    char (*ids)[ID_LEN] = realloc(g->user_ids, (size_t)capacity * ID_LEN);
+    if (ids) g->user_ids = ids;
+    AdjSet* out = realloc(g->out, sizeof(AdjSet) * (size_t)capacity);
+    if (out) g->out = out;
+    AdjSet* in = realloc(g->in, sizeof(AdjSet) * (size_t)capacity);
+    if (in) g->in = in;
+    unsigned char* state = realloc(g->state, (size_t)capacity);
+    if (state) g->state = state;
+    uint64_t* live_bits = realloc(g->live_bits, sizeof(uint64_t) * ((size_t)capacity / 64 + 1));
+    if (live_bits) {
+        size_t old_words = (size_t)g->capacity / 64 + 1;
+        memset(live_bits + old_words, 0, sizeof(uint64_t) * ((size_t)capacity / 64 + 1 - old_words));
+        g->live_bits = live_bits;
+    }
+    int* free_slots = realloc(g->free_slots, sizeof(int) * (size_t)capacity);
+    if (free_slots) g->free_slots = free_slots;
+    if (!ids || !out || !in || !state || !live_bits || !free_slots) return 0;
+
+    Ranks* r = &g->ranks;
+    if (r->score) {
+        double* score = realloc(r->score, sizeof(double) * (size_t)capacity);
+        if (score) r->score = score;
+        double* residual = realloc(r->residual, sizeof(double) * (size_t)capacity);
+        if (residual) r->residual = residual;
+        int* degree = realloc(r->degree, sizeof(int) * (size_t)capacity);
+        if (degree) r->degree = degree;
+        int* queue = realloc(r->queue, sizeof(int) * (size_t)capacity);
+        if (queue) {
+            // Unwrap the ring: entries past the old end move into the new space
+            int wrapped = r->queue_head + r->queue_len - g->capacity;
+            if (wrapped > 0) memcpy(queue + g->capacity, queue, sizeof(int) * (size_t)wrapped);
+            r->queue = queue;
+        }
+        unsigned char* queued = realloc(r->queued, (size_t)capacity);
+        if (queued) {
+            memset(queued + g->capacity, 0, (size_t)(capacity - g->capacity));
+            r->queued = queued;
+        }
+        if (!score || !residual || !degree || !queue || !queued) rank_free(r); // Recomputed when next asked for
+    }
+    g->capacity = capacity;
+    return 1;
+}
+
 // Add a user if they don't exist
 int add_user(SocialGraph* g, const char* id) {
     int idx = get_user_index(g, id);
     if (idx != -1) return idx; // Already exists
-    
-    if (g->num_users >= MAX_USERS) {
-        printf("Error: Max user limit reached.\n");
+
+    if (strlen(id) >= ID_LEN) {
+        printf("Error: User ID %s is too long.\n", id);
+        return -1;
+    }
+    if (g->free_count == 0 && g->num_slots == g->capacity && !grow_users(g, g->capacity * 2)) {
+        printf("Error: Out of memory adding user.\n");
         return -1;
     }
 
-    strcpy(g->user_ids[g->num_users], id);
+    // Reuse a compacted slot before growing
+    int reused = g->free_count > 0;
+    idx = reused ? g->free_slots[--g->free_count] : g->num_slots++;
+    strcpy(g->user_ids[idx], id);
+    memset(&g->out[idx], 0, sizeof(AdjSet));
+    memset(&g->in[idx], 0, sizeof(AdjSet));
+    g->state[idx] = USER_LIVE;
+    g->live_bits[idx / 64] |= 1ULL << (idx % 64);
+    rank_user_added(g, idx);
     g->num_users++;
-    return g->num_users - 1;
+    if (2 * (g->slot_used + 1) > g->slot_count) {
+        if (!rehash_ids(g)) {
+            g->state[idx] = USER_FREE;
+            g->live_bits[idx / 64] &= ~(1ULL << (idx % 64));
+            if (reused) g->free_count++;
+            else g->num_slots--;
+            g->num_users--;
+            printf("Error: Out of memory adding user.\n");
+            return -1;
+        }
+    } else {
+        insert_slot(g, idx);
+    }
+    return idx;
 }
 
 // Add a directed edge (interaction)
@@ -54,7 +558,17 @@ void add_interaction(SocialGraph* g, const char* from_id, const char* to_id) {
     int v = add_user(g, to_id);
 
     if (u != -1 && v != -1) {
-        g->adj_matrix[u][v] = 1; // Directed Edge: u -> v
+        // Directed Edge: u -> v, recorded from both ends
+        int added = adj_insert(g, &g->out[u], v);
+        if (added == 1 && adj_insert(g, &g->in[v], u) < 0) {
+            adj_remove(g, &g->out[u], v); // Only undo the edge this call inserted
+            added = -1;
+        }
+        if (added < 0) {
+            printf("Error: Out of memory logging interaction.\n");
+            return;
+        }
+        if (added) rank_edge_added(g, u, v);
         printf("Interaction Logged: %s -> %s\n", from_id, to_id);
     }
 }
@@ -65,44 +579,35 @@ void remove_interaction(SocialGraph* g, const char* from_id, const char* to_id)
     int v = get_user_index(g, to_id);
 
     if (u != -1 && v != -1) {
-        g->adj_matrix[u][v] = 0;
+        if (adj_remove(g, &g->out[u], v)) rank_edge_removed(g, u, v);
+        adj_remove(g, &g->in[v], u);
         printf("Interaction Removed: %s -> %s\n", from_id, to_id);
     } else {
         printf("Error: One or both users not found.\n");
     }
 }
 
-// Remove a user and all their associated interactions (Node)
+// Remove a user and all their associated interactions (Node).
+// O(1): the slot becomes a tombstone and neighbours' lists are cleaned lazily.
 void remove_user(SocialGraph* g, const char* id) {
-    int k = get_user_index(g, id); // Find the index of the user to remove
+    int s = find_slot(g, id); // Find the user to remove
     
-    if (k == -1) {
+    if (s == -1) {
         printf("Error: User %s not found.\n", id);
         return;
     }
+    int k = g->id_slots[s];
 
-    // Step 1: Shift User IDs array left to overwrite the user
-    for (int i = k; i < g->num_users - 1; i++) {
-        strcpy(g->user_ids[i], g->user_ids[i+1]);
-    }
+    rank_user_removed(g, k);
+    g->id_slots[s] = SLOT_DELETED;
+    g->state[k] = USER_TOMBSTONE;
+    g->live_bits[k / 64] &= ~(1ULL << (k % 64));
+    adj_free(&g->out[k]);
+    adj_free(&g->in[k]);
+    g->num_users--;
+    g->num_dead++;
 
-    // Step 2: Shift Rows up (Overwrite row k)
-    // We iterate from the row we want to remove (k) to the end
-    for (int i = k; i < g->num_users - 1; i++) {
-        for (int j = 0; j < g->num_users; j++) {
-            g->adj_matrix[i][j] = g->adj_matrix[i+1][j];
-        }
-    }
-
-    // Step 3: Shift Columns left (Overwrite column k)
-    // We do this for every row in the matrix
-    for (int i = 0; i < g->num_users; i++) {
-        for (int j = k; j < g->num_users - 1; j++) {
-            g->adj_matrix[i][j] = g->adj_matrix[i][j+1];
-        }
-    }
-
-    g->num_users--; // Decrease the total count
+    if (g->num_dead >= COMPACT_MIN && g->num_dead * COMPACT_RATIO >= g->num_slots) compact_graph(g);
     printf("User %s and all their interactions have been removed.\n", id);
 }
 
@@ -117,70 +622,1339 @@ void query_user(SocialGraph* g, const char* id) {
 
     printf("\n--- Analysis for %s ---\n", id);
 
-    // 1. Outgoing (Who they interact with) -> Scan Row
+    // 1. Outgoing (Who they interact with)
     printf("Interacts WITH (Outgoing): ");
     int found_out = 0;
-    for (int j = 0; j < g->num_users; j++) {
-        if (g->adj_matrix[idx][j] == 1) {
-            printf("%s, ", g->user_ids[j]);
-            found_out = 1;
-        }
+    for (int c = 0, v; (v = adj_next(&g->out[idx], &c)) != -1;) {
+        if (!user_live(g, v)) continue; // Removed user not yet compacted away
+        printf("%s, ", g->user_ids[v]);
+        found_out = 1;
     }
     if (!found_out) printf("None");
     printf("\n");
 
-    // 2. Incoming (Who interacts with them) -> Scan Column
+    // 2. Incoming (Who interacts with them)
     printf("Interacted BY (Incoming):  ");
     int found_in = 0;
-    for (int i = 0; i < g->num_users; i++) {
-        if (g->adj_matrix[i][idx] == 1) {
-            printf("%s, ", g->user_ids[i]);
-            found_in = 1;
-        }
+    for (int c = 0, u; (u = adj_next(&g->in[idx], &c)) != -1;) {
+        if (!user_live(g, u)) continue;
+        printf("%s, ", g->user_ids[u]);
+        found_in = 1;
     }
     if (!found_in) printf("None");
     printf("\n--------------------------\n");
 }
 
+// --- Neighbourhood Queries ---
+// Each set involved is expanded into a dense bitset over all slots (bitset rows
+// are copied word for word), so every query reduces to AND/OR + popcount over
+// num_slots / 64 words, masked with live_bits to skip tombstones.
+
+int slot_words(const SocialGraph* g) {
+    return (g->num_slots + 63) / 64;
+}
+
+// OR the members of 'set' into a dense bitset
+void adj_load(const AdjSet* set, uint64_t* dst, int words) {
+    if (set->bits) {
+        int n = set->words < words ? set->words : words;
+        for (int w = 0; w < n; w++) dst[w] |= set->bits[w];
+    } else {
+        for (int i = 0; i < set->count; i++) dst[set->items[i] / 64] |= 1ULL << (set->items[i] % 64);
+    }
+}
+
+// out[w] = a[w] & b[w] & mask[w] (out may be a); returns the number of bits set
+int and_count(const uint64_t* a, const uint64_t* b, const uint64_t* mask, uint64_t* out, int words) {
+    int total = 0;
+    for (int w = 0; w < words; w++) {
+        out[w] = a[w] & b[w] & mask[w];
+        total += __builtin_popcountll(out[w]);
+    }
+    return total;
+}
+
+int or_count(const uint64_t* a, const uint64_t* b, const uint64_t* mask, int words) {
+    int total = 0;
+    for (int w = 0; w < words; w++) total += __builtin_popcountll((a[w] | b[w]) & mask[w]);
+    return total;
+}
+
+void print_user_bits(const SocialGraph* g, const uint64_t* bits, int words) {
+    for (int w = 0; w < words; w++) {
+        for (uint64_t word = bits[w]; word; word &= word - 1) {
+            printf("%s, ", g->user_ids[w * 64 + __builtin_ctzll(word)]);
+        }
+    }
+}
+
+// Look up two users and expand their sets into fresh bitsets a and b. With
+// 'both_ways', in-edges are added and the two users themselves are excluded.
+// Returns 0 after reporting a problem.
+int load_pair(SocialGraph* g, const char* id1, const char* id2, int both_ways, uint64_t** a, uint64_t** b) {
+    int u = get_user_index(g, id1);
+    int v = get_user_index(g, id2);
+    if (u == -1 || v == -1) {
+        printf("Error: One or both users not found.\n");
+        return 0;
+    }
+    int words = slot_words(g);
+    *a = calloc((size_t)words, sizeof(uint64_t));
+    *b = calloc((size_t)words, sizeof(uint64_t));
+    if (!*a || !*b) {
+        free(*a);
+        free(*b);
+        printf("Error: Out of memory running query.\n");
+        return 0;
+    }
+    adj_load(&g->out[u], *a, words);
+    adj_load(&g->out[v], *b, words);
+    if (both_ways) {
+        adj_load(&g->in[u], *a, words);
+        adj_load(&g->in[v], *b, words);
+        uint64_t self = ~(1ULL << (u % 64)), other = ~(1ULL << (v % 64));
+        (*a)[u / 64] &= self;
+        (*b)[u / 64] &= self;
+        (*a)[v / 64] &= other;
+        (*b)[v / 64] &= other;
+    }
+    return 1;
+}
+
+void print_result(SocialGraph* g, const uint64_t* bits, int n) {
+    print_user_bits(g, bits, slot_words(g));
+    if (n == 0) printf("None");
+    printf("\n");
+}
+
+// Users this user interacts with who also interact back
+void mutual_follows(SocialGraph* g, const char* id) {
+    int u = get_user_index(g, id);
+    if (u == -1) {
+        printf("User %s not found in the system.\n", id);
+        return;
+    }
+    int words = slot_words(g);
+    uint64_t* a = calloc((size_t)words, sizeof(uint64_t));
+    uint64_t* b = calloc((size_t)words, sizeof(uint64_t));
+    if (a && b) {
+        adj_load(&g->out[u], a, words);
+        adj_load(&g->in[u], b, words);
+        int n = and_count(a, b, g->live_bits, a, words);
+        printf("\nMutual follows of %s (%d): ", id, n);
+        print_result(g, a, n);
+    } else {
+        printf("Error: Out of memory running query.\n");
+    }
+    free(a);
+    free(b);
+}
+
+// Users connected (either direction) to both
+void common_neighbours(SocialGraph* g, const char* id1, const char* id2) {
+    uint64_t *a, *b;
+    if (!load_pair(g, id1, id2, 1, &a, &b)) return;
+    int n = and_count(a, b, g->live_bits, a, slot_words(g));
+    printf("\nCommon neighbours of %s and %s (%d): ", id1, id2, n);
+    print_result(g, a, n);
+    free(a);
+    free(b);
+}
+
+// |N(A) & N(B)| / |N(A) | N(B)| over undirected neighbourhoods
+void jaccard_similarity(SocialGraph* g, const char* id1, const char* id2) {
+    uint64_t *a, *b;
+    if (!load_pair(g, id1, id2, 1, &a, &b)) return;
+    int total = or_count(a, b, g->live_bits, slot_words(g));
+    int shared = and_count(a, b, g->live_bits, a, slot_words(g));
+    printf("\nJaccard similarity of %s and %s: %.3f (%d shared of %d neighbours)\n",
+           id1, id2, total ? (double)shared / total : 0.0, shared, total);
+    free(a);
+    free(b);
+}
+
+// Users that both interact with (shared outgoing edges)
+void both_interact_with(SocialGraph* g, const char* id1, const char* id2) {
+    uint64_t *a, *b;
+    if (!load_pair(g, id1, id2, 0, &a, &b)) return;
+    int n = and_count(a, b, g->live_bits, a, slot_words(g));
+    printf("\nBoth %s and %s interact with (%d): ", id1, id2, n);
+    print_result(g, a, n);
+    free(a);
+    free(b);
+}
+
+// --- Worker Pool ---
+// Runs one step function on several threads in lockstep rounds, for the BFS
+// levels and PageRank passes. The calling thread takes share 0. Started
+// threads wait at the gate until the barriers are sized to how many actually
+// started, so a failed pthread_create just means fewer threads.
+
+struct WorkerPool;
+
+typedef struct {
+    struct WorkerPool* pool;
+    int t;
+} PoolWorker;
+
+typedef struct WorkerPool {
+    void (*step)(void* arg, int t);
+    void* arg;
+    int threads;
+    int done;
+    pthread_t ids[MAX_THREADS];
+    PoolWorker workers[MAX_THREADS];
+    pthread_mutex_t gate;
+    pthread_barrier_t start;
+    pthread_barrier_t finish;
+} WorkerPool;
+
+void* pool_worker(void* arg) {
+    PoolWorker* worker = (PoolWorker*)arg;
+    WorkerPool* pool = worker->pool;
+    pthread_mutex_lock(&pool->gate);
+    pthread_mutex_unlock(&pool->gate);
+    while (1) {
+        pthread_barrier_wait(&pool->start);
+        if (pool->done) break;
+        pool->step(pool->arg, worker->t);
+        pthread_barrier_wait(&pool->finish);
+    }
+    return NULL;
+}
+
+// Start up to 'wanted' threads (the caller included) running step(arg, t)
+void pool_start(WorkerPool* pool, int wanted, void (*step)(void*, int), void* arg) {
+    pool->step = step;
+    pool->arg = arg;
+    pool->threads = 1;
+    pool->done = 0;
+    pthread_mutex_init(&pool->gate, NULL);
+    pthread_mutex_lock(&pool->gate);
+    while (pool->threads < wanted) {
+        PoolWorker* worker = &pool->workers[pool->threads];
+        worker->pool = pool;
+        worker->t = pool->threads;
+        if (pthread_create(&pool->ids[pool->threads], NULL, pool_worker, worker) != 0) break;
+        pool->threads++;
+    }
+    pthread_barrier_init(&pool->start, NULL, (unsigned)pool->threads);
+    pthread_barrier_init(&pool->finish, NULL, (unsigned)pool->threads);
+    pthread_mutex_unlock(&pool->gate);
+}
+
+// One round: every thread runs its share and the caller waits for all of them
+void pool_run(WorkerPool* pool) {
+    if (pool->threads > 1) pthread_barrier_wait(&pool->start);
+    pool->step(pool->arg, 0);
+    if (pool->threads > 1) pthread_barrier_wait(&pool->finish);
+}
+
+void pool_stop(WorkerPool* pool) {
+    if (pool->threads > 1) {
+        pool->done = 1;
+        pthread_barrier_wait(&pool->start);
+        for (int t = 1; t < pool->threads; t++) pthread_join(pool->ids[t], NULL);
+    }
+    pthread_barrier_destroy(&pool->start);
+    pthread_barrier_destroy(&pool->finish);
+    pthread_mutex_destroy(&pool->gate);
+}
+
+// --- Multi-hop Queries (parallel BFS) ---
+// Levels are expanded over a frontier bitmap. Top-down steps push along the
+// frontier's out-edges; once the frontier's edges outweigh what is left to
+// explore, bottom-up steps instead let each unvisited user look for a parent
+// among its in-edges. Threads grab BFS_CHUNK_WORDS words of the bitmap at a time.
+
+typedef struct {
+    SocialGraph* g;
+    int* dist;              // Hops from the source, -1 if not reached
+    int* parent;            // Previous user on a shortest chain
+    uint64_t* visited;
+    uint64_t* frontier;
+    uint64_t* next;
+    int words;
+    int level;
+    int bottom_up;
+    atomic_int next_chunk;
+    WorkerPool pool;
+    long found[MAX_THREADS];     // Users reached this level, per thread
+    long out_edges[MAX_THREADS]; // Their out-degrees (next top-down cost)
+    long in_edges[MAX_THREADS];  // Their in-degrees (leave the bottom-up cost)
+} BfsState;
+
+// Find a frontier user among v's in-edges, or -1
+int frontier_parent(const BfsState* s, const AdjSet* in) {
+    if (in->bits) {
+        int n = in->words < s->words ? in->words : s->words;
+        for (int w = 0; w < n; w++) {
+            uint64_t hit = in->bits[w] & s->frontier[w];
+            if (hit) return w * 64 + __builtin_ctzll(hit);
+        }
+        return -1;
+    }
+    for (int i = 0; i < in->count; i++) {
+        int u = in->items[i];
+        if ((s->frontier[u / 64] >> (u % 64)) & 1) return u;
+    }
+    return -1;
+}
+
+// Thread t's share of one level
+void bfs_step(void* arg, int t) {
+    BfsState* s = (BfsState*)arg;
+    SocialGraph* g = s->g;
+    long found = 0, out_edges = 0, in_edges = 0;
+
+    while (1) {
+        int w0 = atomic_fetch_add(&s->next_chunk, 1) * BFS_CHUNK_WORDS;
+        if (w0 >= s->words) break;
+        int w1 = w0 + BFS_CHUNK_WORDS < s->words ? w0 + BFS_CHUNK_WORDS : s->words;
+
+        for (int w = w0; w < w1; w++) {
+            if (!s->bottom_up) {
+                for (uint64_t word = s->frontier[w]; word; word &= word - 1) {
+                    int u = w * 64 + __builtin_ctzll(word);
+                    for (int c = 0, v; (v = adj_next(&g->out[u], &c)) != -1;) {
+                        uint64_t bit = 1ULL << (v % 64);
+                        if (!(g->live_bits[v / 64] & bit)) continue;
+                        if (__atomic_load_n(&s->visited[v / 64], __ATOMIC_RELAXED) & bit) continue;
+                        // Several threads may find v; the one that sets the bit owns it
+                        if (__atomic_fetch_or(&s->visited[v / 64], bit, __ATOMIC_RELAXED) & bit) continue;
+                        __atomic_fetch_or(&s->next[v / 64], bit, __ATOMIC_RELAXED);
+                        s->dist[v] = s->level + 1;
+                        s->parent[v] = u;
+                        found++;
+                        out_edges += g->out[v].count;
+                        in_edges += g->in[v].count;
+                    }
+                }
+            } else {
+                // This thread owns words w0..w1, so no atomics are needed
+                for (uint64_t todo = g->live_bits[w] & ~s->visited[w]; todo; todo &= todo - 1) {
+                    int v = w * 64 + __builtin_ctzll(todo);
+                    int u = frontier_parent(s, &g->in[v]);
+                    if (u == -1) continue;
+                    s->visited[w] |= 1ULL << (v % 64);
+                    s->next[w] |= 1ULL << (v % 64);
+                    s->dist[v] = s->level + 1;
+                    s->parent[v] = u;
+                    found++;
+                    out_edges += g->out[v].count;
+                    in_edges += g->in[v].count;
+                }
+            }
+        }
+    }
+    s->found[t] = found;
+    s->out_edges[t] = out_edges;
+    s->in_edges[t] = in_edges;
+}
+
+int core_count(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1) return 1;
+    return cpus > MAX_THREADS ? MAX_THREADS : (int)cpus;
+}
+
+int bfs_thread_count(const SocialGraph* g) {
+    return g->num_slots < BFS_PARALLEL_MIN ? 1 : core_count();
+}
+
+// Breadth-first search along interactions from 'source', stopping after
+// 'max_depth' hops (-1: no limit) or once 'target' (-1: none) is reached.
+// Fills dist/parent (num_slots entries) and returns the users reached,
+// the source included, or -1 if out of memory.
+int bfs(SocialGraph* g, int source, int max_depth, int target, int* dist, int* parent) {
+    static BfsState s;
+
+    s.g = g;
+    s.dist = dist;
+    s.parent = parent;
+    s.words = slot_words(g);
+    s.visited = calloc((size_t)s.words, sizeof(uint64_t));
+    s.frontier = calloc((size_t)s.words, sizeof(uint64_t));
+    s.next = calloc((size_t)s.words, sizeof(uint64_t));
+    if (!s.visited || !s.frontier || !s.next) {
+        free(s.visited);
+        free(s.frontier);
+        free(s.next);
+        return -1;
+    }
+    for (int i = 0; i < g->num_slots; i++) dist[i] = parent[i] = -1;
+    dist[source] = 0;
+    s.visited[source / 64] = s.frontier[source / 64] = 1ULL << (source % 64);
+
+    long unexplored = 0; // In-edges of unvisited users: the bottom-up cost
+    for (int i = 0; i < g->num_slots; i++) {
+        if (user_live(g, i) && i != source) unexplored += g->in[i].count;
+    }
+    long frontier_edges = g->out[source].count;
+    long frontier_size = 1;
+    int reached = 1;
+
+    s.level = 0;
+    s.bottom_up = 0;
+    pool_start(&s.pool, bfs_thread_count(g), bfs_step, &s);
+
+    while (frontier_size > 0 && s.level != max_depth && (target == -1 || dist[target] == -1)) {
+        if (!s.bottom_up && frontier_edges > unexplored / BFS_ALPHA) s.bottom_up = 1;
+        else if (s.bottom_up && frontier_size < g->num_users / BFS_BETA) s.bottom_up = 0;
+        memset(s.next, 0, sizeof(uint64_t) * (size_t)s.words);
+        atomic_store(&s.next_chunk, 0);
+
+        pool_run(&s.pool);
+
+        frontier_size = frontier_edges = 0;
+        for (int t = 0; t < s.pool.threads; t++) {
+            frontier_size += s.found[t];
+            frontier_edges += s.out_edges[t];
+            unexplored -= s.in_edges[t];
+        }
+        reached += (int)frontier_size;
+        uint64_t* swap = s.frontier;
+        s.frontier = s.next;
+        s.next = swap;
+        s.level++;
+    }
+
+    pool_stop(&s.pool);
+    free(s.visited);
+    free(s.frontier);
+    free(s.next);
+    return reached;
+}
+
+// Run a BFS from 'id' with freshly allocated dist/parent arrays. Returns the
+// reached count, or -1 after reporting a problem (arrays are then freed).
+int bfs_from(SocialGraph* g, const char* id, int max_depth, int target, int** dist, int** parent) {
+    int u = get_user_index(g, id);
+    if (u == -1) {
+        printf("User %s not found in the system.\n", id);
+        return -1;
+    }
+    *dist = malloc(sizeof(int) * (size_t)(g->num_slots + 1));
+    *parent = malloc(sizeof(int) * (size_t)(g->num_slots + 1));
+    int reached = (*dist && *parent) ? bfs(g, u, max_depth, target, *dist, *parent) : -1;
+    if (reached < 0) {
+        printf("Error: Out of memory running search.\n");
+        free(*dist);
+        free(*parent);
+    }
+    return reached;
+}
+
+// Everyone reachable from 'id' in at most k interaction hops, grouped by hop
+void k_hop_reach(SocialGraph* g, const char* id, int k) {
+    int *dist, *parent;
+    if (k < 1) {
+        printf("Error: Hop limit must be at least 1.\n");
+        return;
+    }
+    int reached = bfs_from(g, id, k, -1, &dist, &parent);
+    if (reached < 0) return;
+
+    printf("\n--- Within %d hops of %s: %d users ---\n", k, id, reached - 1);
+    for (int hop = 1; hop <= k; hop++) {
+        int shown = 0, total = 0;
+        for (int v = 0; v < g->num_slots; v++) {
+            if (dist[v] != hop) continue;
+            if (total == 0) printf("Hop %d: ", hop);
+            if (shown < REACH_SHOW) {
+                printf("%s, ", g->user_ids[v]);
+                shown++;
+            }
+            total++;
+        }
+        if (total == 0) break; // Nothing further out either
+        if (total > shown) printf("... (%d in total)", total);
+        printf("\n");
+    }
+    free(dist);
+    free(parent);
+}
+
+// Fewest-hop chain of interactions from id1 to id2
+void shortest_chain(SocialGraph* g, const char* id1, const char* id2) {
+    int *dist, *parent;
+    int target = get_user_index(g, id2);
+    if (target == -1) {
+        printf("User %s not found in the system.\n", id2);
+        return;
+    }
+    if (bfs_from(g, id1, -1, target, &dist, &parent) < 0) return;
+
+    if (dist[target] == -1) {
+        printf("\nNo interaction chain from %s to %s.\n", id1, id2);
+    } else {
+        // Walk parents back from the target, then print forwards
+        int hops = dist[target];
+        int* chain = malloc(sizeof(int) * (size_t)(hops + 1));
+        if (chain) {
+            for (int v = target, i = hops; i >= 0; v = parent[v], i--) chain[i] = v;
+            printf("\nShortest chain (%d hops): ", hops);
+            for (int i = 0; i <= hops; i++) printf(i ? " -> %s" : "%s", g->user_ids[chain[i]]);
+            printf("\n");
+            free(chain);
+        }
+    }
+    free(dist);
+    free(parent);
+}
+
+// How many users 'id' reaches through any chain of interactions
+void reach_size(SocialGraph* g, const char* id) {
+    int *dist, *parent;
+    int reached = bfs_from(g, id, -1, -1, &dist, &parent);
+    if (reached < 0) return;
+    int depth = 0;
+    for (int v = 0; v < g->num_slots; v++) {
+        if (dist[v] > depth) depth = dist[v];
+    }
+    printf("\n%s reaches %d of %d other users (furthest %d hops away).\n",
+           id, reached - 1, g->num_users - 1, depth);
+    free(dist);
+    free(parent);
+}
+
+// --- Centrality (PageRank) ---
+// A full computation is a parallel pull-style power iteration: each user sums
+// what its in-neighbours sent last round, reading a per-user score/degree
+// share so no atomics are needed. Afterwards edge updates only leave
+// residuals behind (see rank_edge_added), and a refresh pushes those out from
+// the affected users alone, in FIFO order so that residual arriving at a user
+// from several directions is pushed once. It falls back to a full
+// iteration when too many users are queued, or when pushing has cost as many
+// edge visits as an iteration would.
+
+typedef struct {
+    SocialGraph* g;
+    double* next;           // This round's scores
+    double* share;          // Last round's score / out-degree, 0 if dangling
+    double* next_share;
+    int setup;              // First pass: count degrees and fill 'share'
+    atomic_int next_chunk;
+    WorkerPool pool;
+    double change[MAX_THREADS]; // Sum of |next - score| per thread
+} RankPass;
+
+// Thread t's share of one pass
+void rank_step(void* arg, int t) {
+    RankPass* p = (RankPass*)arg;
+    SocialGraph* g = p->g;
+    Ranks* r = &g->ranks;
+    double change = 0;
+
+    while (1) {
+        int v0 = atomic_fetch_add(&p->next_chunk, 1) * RANK_CHUNK;
+        if (v0 >= g->num_slots) break;
+        int v1 = v0 + RANK_CHUNK < g->num_slots ? v0 + RANK_CHUNK : g->num_slots;
+
+        for (int v = v0; v < v1; v++) {
+            if (!user_live(g, v)) { // Tombstones send nothing
+                if (p->setup) p->share[v] = 0;
+                else p->next[v] = p->next_share[v] = 0;
+                continue;
+            }
+            if (p->setup) {
+                r->degree[v] = live_count(g, &g->out[v]);
+                p->share[v] = r->degree[v] ? r->score[v] / r->degree[v] : 0;
+                continue;
+            }
+            double sum = 0;
+            for (int c = 0, u; (u = adj_next(&g->in[v], &c)) != -1;) sum += p->share[u];
+            double x = (1.0 - RANK_DAMPING) + RANK_DAMPING * sum;
+            change += fabs(x - r->score[v]);
+            p->next[v] = x;
+            p->next_share[v] = r->degree[v] ? x / r->degree[v] : 0;
+        }
+    }
+    p->change[t] = change;
+}
+
+// Iterate from the current scores until the mean change per user drops
+// below RANK_TOLERANCE. Returns the passes run, or -1 if out of memory.
+int rank_iterate(SocialGraph* g) {
+    static RankPass p;
+    Ranks* r = &g->ranks;
+
+    p.g = g;
+    p.next = malloc(sizeof(double) * (size_t)g->capacity); // Becomes r->score
+    p.share = malloc(sizeof(double) * (size_t)g->capacity);
+    p.next_share = malloc(sizeof(double) * (size_t)g->capacity);
+    if (!p.next || !p.share || !p.next_share) {
+        free(p.next);
+        free(p.share);
+        free(p.next_share);
+        return -1;
+    }
+    pool_start(&p.pool, bfs_thread_count(g), rank_step, &p);
+
+    int iterations = 0;
+    for (p.setup = 1;; p.setup = 0) {
+        atomic_store(&p.next_chunk, 0);
+        pool_run(&p.pool);
+        if (p.setup) continue;
+
+        double change = 0;
+        for (int t = 0; t < p.pool.threads; t++) change += p.change[t];
+        double* swap = r->score;
+        r->score = p.next;
+        p.next = swap;
+        swap = p.share;
+        p.share = p.next_share;
+        p.next_share = swap;
+        iterations++;
+        if (change <= RANK_TOLERANCE * g->num_users || iterations == RANK_MAX_ITER) break;
+    }
+
+    pool_stop(&p.pool);
+    free(p.next);
+    free(p.share);
+    free(p.next_share);
+
+    // Converged: nothing is left to push
+    memset(r->residual, 0, sizeof(double) * (size_t)g->num_slots);
+    memset(r->queued, 0, (size_t)g->num_slots);
+    r->queue_head = r->queue_len = 0;
+    r->edges = 0;
+    for (int i = 0; i < g->num_slots; i++) r->edges += r->degree[i];
+    return iterations;
+}
+
+// Push queued residuals until none exceeds RANK_EPSILON. Returns the pushes
+// made, or -1 once they have visited as many edges as a full iteration would
+// (the residuals left queued are still consistent, so iterating finishes the job).
+long rank_push(SocialGraph* g) {
+    Ranks* r = &g->ranks;
+    long pushes = 0;
+    long budget = r->edges + g->num_users;
+    while (r->queue_len > 0) {
+        if (budget < 0) return -1;
+        int u = r->queue[r->queue_head];
+        r->queue_head = (r->queue_head + 1) % g->capacity;
+        r->queue_len--;
+        r->queued[u] = 0;
+        double ru = r->residual[u];
+        if (!user_live(g, u) || fabs(ru) <= RANK_EPSILON) continue;
+        r->score[u] += ru;
+        r->residual[u] = 0;
+        pushes++;
+        budget -= 1 + r->degree[u];
+        if (r->degree[u] == 0) continue;
+        double share = RANK_DAMPING * ru / r->degree[u];
+        for (int c = 0, v; (v = adj_next(&g->out[u], &c)) != -1;) {
+            if (user_live(g, v)) rank_add_residual(g, v, share);
+        }
+    }
+    return pushes;
+}
+
+// Bring the scores up to date, computing them from scratch the first time.
+// Returns 0 (after reporting it) if out of memory.
+int rank_refresh(SocialGraph* g) {
+    Ranks* r = &g->ranks;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    int iterations = 0;
+    long pushes = 0;
+    int restart = 1;
+    if (!r->score) {
+        size_t n = (size_t)g->capacity;
+        r->score = malloc(sizeof(double) * n);
+        r->residual = malloc(sizeof(double) * n);
+        r->degree = malloc(sizeof(int) * n);
+        r->queue = malloc(sizeof(int) * n);
+        r->queued = calloc(n, 1); // Slots past num_slots must start unqueued too
+        if (!r->score || !r->residual || !r->degree || !r->queue || !r->queued) {
+            rank_free(r);
+            printf("Error: Out of memory computing PageRank.\n");
+            return 0;
+        }
+    } else if (r->queue_len > 0 && r->queue_len <= g->num_users / RANK_PUSH_RATIO) {
+        pushes = rank_push(g);
+        restart = pushes < 0; // Pushing cost more than iterating
+    } else if (r->queue_len == 0) {
+        return 1; // Already current
+    }
+    if (restart) {
+        // Start from scratch rather than the current scores: what is left of
+        // their error is mostly in the mode the iteration shrinks slowest
+        for (int i = 0; i < g->num_slots; i++) r->score[i] = 1.0;
+        iterations = rank_iterate(g);
+    }
+    if (iterations < 0) {
+        rank_free(r);
+        printf("Error: Out of memory computing PageRank.\n");
+        return 0;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ms = (double)(t1.tv_sec - t0.tv_sec) * 1e3 + (double)(t1.tv_nsec - t0.tv_nsec) / 1e6;
+    if (iterations > 0) printf("PageRank computed over %d users in %d iterations (%.2f ms).\n", g->num_users, iterations, ms);
+    else printf("PageRank refreshed with %ld pushes (%.2f ms).\n", pushes, ms);
+    return 1;
+}
+
+// Sort key for the top-k query
+double centrality(const SocialGraph* g, int idx, char metric) {
+    if (metric == 'i') return live_count(g, &g->in[idx]);
+    if (metric == 'o') return live_count(g, &g->out[idx]);
+    return g->ranks.score[idx];
+}
+
+// Heap order: lower key first, and on ties the later slot first, so the
+// k survivors are the highest keys with earlier slots winning ties
+int heap_less(const double* key, const int* idx, int a, int b) {
+    return key[a] < key[b] || (key[a] == key[b] && idx[a] > idx[b]);
+}
+
+void heap_swap(double* key, int* idx, int a, int b) {
+    double k = key[a];
+    key[a] = key[b];
+    key[b] = k;
+    int i = idx[a];
+    idx[a] = idx[b];
+    idx[b] = i;
+}
+
+void heap_sift_down(double* key, int* idx, int n, int i) {
+    while (1) {
+        int least = i, l = 2 * i + 1, r = l + 1;
+        if (l < n && heap_less(key, idx, l, least)) least = l;
+        if (r < n && heap_less(key, idx, r, least)) least = r;
+        if (least == i) return;
+        heap_swap(key, idx, i, least);
+        i = least;
+    }
+}
+
+// Top-k users by metric: 'p' PageRank, 'i' in-degree, 'o' out-degree.
+// A size-k min-heap keeps this O(V log k).
+void top_influencers(SocialGraph* g, int k, char metric) {
+    if (metric != 'p' && metric != 'i' && metric != 'o') {
+        printf("Error: Unknown metric '%c' (use p, i or o).\n", metric);
+        return;
+    }
+    if (k < 1) {
+        printf("Error: k must be at least 1.\n");
+        return;
+    }
+    if (!rank_refresh(g)) return;
+    if (k > g->num_users) k = g->num_users;
+    double* key = malloc(sizeof(double) * ((size_t)k + 1));
+    int* idx = malloc(sizeof(int) * ((size_t)k + 1));
+    if (!key || !idx) {
+        printf("Error: Out of memory.\n");
+        free(key);
+        free(idx);
+        return;
+    }
+
+    int n = 0;
+    for (int v = 0; v < g->num_slots; v++) {
+        if (!user_live(g, v)) continue;
+        double value = centrality(g, v, metric);
+        if (n < k) {
+            key[n] = value;
+            idx[n] = v;
+            for (int i = n++; i > 0 && heap_less(key, idx, i, (i - 1) / 2); i = (i - 1) / 2) {
+                heap_swap(key, idx, i, (i - 1) / 2);
+            }
+        } else if (value > key[0]) { // Ties go to the earlier slot already held
+            key[0] = value;
+            idx[0] = v;
+            heap_sift_down(key, idx, n, 0);
+        }
+    }
+    // Popping the minimum to the back leaves the array in descending order
+    for (int end = n - 1; end > 0; end--) {
+        heap_swap(key, idx, 0, end);
+        heap_sift_down(key, idx, end, 0);
+    }
+
+    const char* name = metric == 'i' ? "In-Degree" : metric == 'o' ? "Out-Degree" : "PageRank";
+    printf("\n--- Top %d by %s ---\n", n, name);
+    printf("  #  %-*s  PageRank     In    Out\n", ID_LEN - 1, "User");
+    for (int i = 0; i < n; i++) {
+        int v = idx[i];
+        printf("%3d. %-*s %9.4f %6d %6d\n", i + 1, ID_LEN - 1, g->user_ids[v], g->ranks.score[v],
+               live_count(g, &g->in[v]), live_count(g, &g->out[v]));
+    }
+    printf("--------------------------\n");
+    free(key);
+    free(idx);
+}
+
+void user_centrality(SocialGraph* g, const char* id) {
+    int v = get_user_index(g, id);
+    if (v == -1) {
+        printf("Error: User %s not found.\n", id);
+        return;
+    }
+    if (!rank_refresh(g)) return;
+    int position = 1;
+    for (int u = 0; u < g->num_slots; u++) {
+        if (user_live(g, u) && g->ranks.score[u] > g->ranks.score[v]) position++;
+    }
+    printf("\n--- Centrality for %s ---\n", id);
+    printf("PageRank:   %.4f (#%d of %d)\n", g->ranks.score[v], position, g->num_users);
+    printf("In-degree:  %d\n", live_count(g, &g->in[v]));
+    printf("Out-degree: %d\n", live_count(g, &g->out[v]));
+    printf("--------------------------\n");
+}
+
 // --- Matrix Display ---
 void print_adjacency_matrix(SocialGraph* g) {
+    if (g->num_users > MATRIX_SHOW) {
+        printf("\nGraph has %d users; too large to show as a matrix. Query users instead.\n", g->num_users);
+        return;
+    }
     printf("\nAdjacency Matrix:\n      ");
-    for (int i = 0; i < g->num_users; i++) {
-        printf("%s ", g->user_ids[i]);
+    for (int i = 0; i < g->num_slots; i++) {
+        if (user_live(g, i)) printf("%s ", g->user_ids[i]);
     }
     printf("\n");
 
-    for (int i = 0; i < g->num_users; i++) {
+    for (int i = 0; i < g->num_slots; i++) {
+        if (!user_live(g, i)) continue;
         printf("%s  ", g->user_ids[i]);
-        for (int j = 0; j < g->num_users; j++) {
-            printf("  %d  ", g->adj_matrix[i][j]);
+        for (int j = 0; j < g->num_slots; j++) {
+            if (user_live(g, j)) printf("  %d  ", adj_contains(&g->out[i], j));
         }
         printf("\n");
     }
 }
 
+// --- Bulk Import ---
+// The file is memory-mapped and split at line boundaries into one chunk per
+// core. Chunks are tokenised in parallel into (offset, length) pairs, IDs are
+// then interned serially, and the edges are radix-sorted and deduplicated so
+// each adjacency list is filled by appending.
+
+// An ID inside the mapped file: offset << 8 | length
+typedef uint64_t IdToken;
+
+typedef struct {
+    const char* data;
+    size_t begin, end;      // Byte range of whole lines
+    IdToken* edges;         // Pairs: edges[2i] -> edges[2i+1]
+    size_t count, capacity; // In edges
+    size_t malformed;       // Lines without exactly two valid IDs
+} ParseChunk;
+
+int is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+void* parse_chunk(void* arg) {
+    ParseChunk* chunk = (ParseChunk*)arg;
+    const char* data = chunk->data;
+    size_t pos = chunk->begin;
+
+    while (pos < chunk->end) {
+        const char* nl = memchr(data + pos, '\n', chunk->end - pos);
+        size_t line_end = nl ? (size_t)(nl - data) : chunk->end;
+        size_t tok[2], len[2];
+        int tokens = 0;
+
+        for (size_t i = pos; i < line_end;) {
+            if (is_blank(data[i])) {
+                i++;
+                continue;
+            }
+            size_t start = i;
+            while (i < line_end && !is_blank(data[i])) i++;
+            if (tokens < 2) {
+                tok[tokens] = start;
+                len[tokens] = i - start;
+            }
+            tokens++;
+        }
+        pos = line_end + 1;
+
+        if (tokens == 0 || data[tok[0]] == '#') continue; // Blank line or comment
+        if (tokens != 2 || len[0] >= ID_LEN || len[1] >= ID_LEN) {
+            chunk->malformed++;
+            continue;
+        }
+        if (chunk->count == chunk->capacity) {
+            size_t capacity = chunk->capacity ? chunk->capacity * 2 : 1024;
+            IdToken* grown = realloc(chunk->edges, sizeof(IdToken) * 2 * capacity);
+            if (!grown) {
+                chunk->malformed++; // Counted so the summary shows the loss
+                continue;
+            }
+            chunk->edges = grown;
+            chunk->capacity = capacity;
+        }
+        chunk->edges[2 * chunk->count] = (uint64_t)tok[0] << 8 | len[0];
+        chunk->edges[2 * chunk->count + 1] = (uint64_t)tok[1] << 8 | len[1];
+        chunk->count++;
+    }
+    return NULL;
+}
+
+// Intern a token's ID without console output. Returns the user index or -1.
+int intern_token(SocialGraph* g, const char* data, IdToken token) {
+    char id[ID_LEN];
+    size_t len = token & 0xFF;
+    memcpy(id, data + (token >> 8), len);
+    id[len] = '\0';
+    return add_user(g, id);
+}
+
+// LSD radix sort on 64-bit keys, 16 bits per pass
+void radix_sort(uint64_t* keys, uint64_t* tmp, size_t n) {
+    static size_t counts[1 << 16];
+    if (n < 2) return; // Already sorted, and keys[0] may not exist
+    for (int shift = 0; shift < 64; shift += 16) {
+        memset(counts, 0, sizeof(counts));
+        for (size_t i = 0; i < n; i++) counts[(keys[i] >> shift) & 0xFFFF]++;
+        if (counts[(keys[0] >> shift) & 0xFFFF] == n) continue; // Digit is the same everywhere
+        size_t sum = 0;
+        for (int d = 0; d < (1 << 16); d++) {
+            size_t c = counts[d];
+            counts[d] = sum;
+            sum += c;
+        }
+        for (size_t i = 0; i < n; i++) tmp[counts[(keys[i] >> shift) & 0xFFFF]++] = keys[i];
+        memcpy(keys, tmp, sizeof(uint64_t) * n);
+    }
+}
+
+// Import a "from_id to_id" per line edge list. Returns 0 after reporting a problem.
+int import_edge_list(SocialGraph* g, const char* path) {
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        printf("Error: Could not open %s.\n", path);
+        if (fd >= 0) close(fd);
+        return 0;
+    }
+    size_t size = (size_t)st.st_size;
+    if (size == 0) {
+        close(fd);
+        printf("Imported 0 interactions from %s.\n", path);
+        return 1;
+    }
+    const char* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        printf("Error: Could not map %s.\n", path);
+        return 0;
+    }
+    madvise((void*)data, size, MADV_SEQUENTIAL);
+
+    // 1. Tokenise chunks in parallel
+    ParseChunk chunks[MAX_THREADS];
+    pthread_t threads[MAX_THREADS];
+    int started[MAX_THREADS];
+    int parts = size < LOAD_PARALLEL_MIN ? 1 : core_count();
+    size_t begin = 0;
+    for (int t = 0; t < parts; t++) {
+        size_t end = size * (size_t)(t + 1) / (size_t)parts;
+        const char* nl = end < size ? memchr(data + end, '\n', size - end) : NULL;
+        end = t == parts - 1 || !nl ? size : (size_t)(nl - data) + 1;
+        memset(&chunks[t], 0, sizeof(ParseChunk));
+        chunks[t].data = data;
+        chunks[t].begin = begin < end ? begin : end;
+        chunks[t].end = end;
+        begin = end;
+    }
+    for (int t = 1; t < parts; t++) started[t] = pthread_create(&threads[t], NULL, parse_chunk, &chunks[t]) == 0;
+    parse_chunk(&chunks[0]);
+    for (int t = 1; t < parts; t++) {
+        if (started[t]) pthread_join(threads[t], NULL);
+        else parse_chunk(&chunks[t]); // No thread to spare: parse it here
+    }
+
+    // 2. Intern IDs in file order and pack each edge as a sortable key
+    size_t total = 0, malformed = 0;
+    for (int t = 0; t < parts; t++) {
+        total += chunks[t].count;
+        malformed += chunks[t].malformed;
+    }
+    uint64_t* keys = malloc(sizeof(uint64_t) * (total + 1));
+    size_t n = 0;
+    int ok = keys != NULL;
+    if (!ok) printf("Error: Out of memory importing %s.\n", path);
+    for (int t = 0; t < parts; t++) {
+        for (size_t i = 0; ok && i < chunks[t].count; i++) {
+            int u = intern_token(g, data, chunks[t].edges[2 * i]);
+            int v = intern_token(g, data, chunks[t].edges[2 * i + 1]);
+            if (u == -1 || v == -1) {
+                ok = 0; // add_user has reported why
+                break;
+            }
+            keys[n++] = (uint64_t)u << 32 | (uint32_t)v;
+        }
+        free(chunks[t].edges);
+    }
+    munmap((void*)data, size);
+
+    // 3. Sort, drop duplicates, and append to the adjacency sets
+    uint64_t* tmp = ok ? malloc(sizeof(uint64_t) * (n + 1)) : NULL;
+    if (!tmp) {
+        if (ok) printf("Error: Out of memory importing %s.\n", path);
+        free(keys);
+        return 0;
+    }
+    radix_sort(keys, tmp, n);
+    free(tmp);
+
+    size_t added = 0, duplicates = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (i > 0 && keys[i] == keys[i - 1]) {
+            duplicates++;
+            continue;
+        }
+        int u = (int)(keys[i] >> 32);
+        int v = (int)(uint32_t)keys[i];
+        int r = adj_insert(g, &g->out[u], v);
+        if (r == 1 && adj_insert(g, &g->in[v], u) < 0) {
+            adj_remove(g, &g->out[u], v);
+            r = -1;
+        }
+        if (r < 0) {
+            printf("Error: Out of memory importing %s.\n", path);
+            free(keys);
+            return 0;
+        }
+        if (r == 1) {
+            rank_edge_added(g, u, v);
+            added++;
+        } else {
+            duplicates++; // Already in the graph
+        }
+    }
+    free(keys);
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+    printf("Imported %zu interactions from %s in %.2f s: %zu new, %zu duplicate, %zu malformed lines skipped.\n",
+           n, path, secs, added, duplicates, malformed);
+    printf("Graph now has %d users.\n", g->num_users);
+    return 1;
+}
+
+// --- Binary Snapshot ---
+
+// File layout: this header, then 8-byte aligned sections holding the ID table
+// (num_users x ID_LEN), the ID hash table (hash_slots int32 indices), and CSR
+// out and in adjacency (num_users + 1 uint64 offsets, then num_edges int32
+// targets, each). Users are numbered densely in slot order, so every row is
+// already sorted and the file maps straight into the graph.
+typedef struct {
+    uint32_t magic;      // SNAPSHOT_MAGIC
+    uint32_t version;    // SNAPSHOT_VERSION
+    uint32_t id_len;     // ID_LEN the file was written with
+    uint32_t num_users;
+    uint64_t num_edges;
+    uint64_t hash_slots; // Power of two, at most half full
+    uint64_t checksum;   // Over the header (this field read as 0) and the sections it declares
+    uint64_t reserved[3];
+} SnapshotHeader;
+
+typedef struct {
+    size_t ids, slots, out_offsets, out_edges, in_offsets, in_edges, end;
+} SnapshotLayout;
+
+size_t align8(size_t x) {
+    return (x + 7) & ~(size_t)7;
+}
+
+void snapshot_layout(SnapshotLayout* l, size_t users, size_t edges, size_t slots) {
+    l->ids = sizeof(SnapshotHeader);
+    l->slots = l->ids + align8(users * ID_LEN);
+    l->out_offsets = l->slots + align8(slots * sizeof(int32_t));
+    l->out_edges = l->out_offsets + (users + 1) * sizeof(uint64_t);
+    l->in_offsets = l->out_edges + align8(edges * sizeof(int32_t));
+    l->in_edges = l->in_offsets + (users + 1) * sizeof(uint64_t);
+    l->end = l->in_edges + align8(edges * sizeof(int32_t));
+}
+
+// 64-bit multiplicative hash over whole words; any single corrupted word changes it
+uint64_t hash_words(uint64_t h, const uint64_t* words, size_t count) {
+    for (size_t i = 0; i < count; i++) h = (h ^ words[i]) * 1099511628211ULL;
+    return h;
+}
+
+// Covers the header and the sections laid out from it, ids through in_edges
+uint64_t snapshot_checksum(const unsigned char* data, const SnapshotLayout* l) {
+    SnapshotHeader header = *(const SnapshotHeader*)data;
+    header.checksum = 0;
+    uint64_t h = hash_words(14695981039346656037ULL, (const uint64_t*)&header, sizeof(header) / 8);
+    return hash_words(h, (const uint64_t*)(data + l->ids), (l->end - l->ids) / 8) ^ l->end;
+}
+
+// Write out[] or in[] as CSR over dense indices, skipping tombstoned members
+void write_csr(const SocialGraph* g, const AdjSet* rows, const int* dense, uint64_t* offsets, int32_t* edges) {
+    uint64_t k = 0;
+    int n = 0;
+    for (int i = 0; i < g->num_slots; i++) {
+        if (!user_live(g, i)) continue;
+        offsets[n++] = k;
+        for (int c = 0, v; (v = adj_next(&rows[i], &c)) != -1;) {
+            if (user_live(g, v)) edges[k++] = dense[v];
+        }
+    }
+    offsets[n] = k;
+}
+
+// Written to a temporary file and renamed over 'path', so a graph that is
+// still borrowing rows from the old file keeps a valid mapping.
+int save_snapshot(SocialGraph* g, const char* path) {
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    int* dense = malloc(sizeof(int) * ((size_t)g->num_slots + 1));
+    if (!dense) {
+        printf("Error: Out of memory saving snapshot.\n");
+        return 0;
+    }
+    int n = 0;
+    uint64_t edges = 0;
+    for (int i = 0; i < g->num_slots; i++) {
+        if (!user_live(g, i)) continue;
+        dense[i] = n++;
+        for (int c = 0, v; (v = adj_next(&g->out[i], &c)) != -1;) edges += user_live(g, v);
+    }
+    size_t slots = 16;
+    while (slots < 4 * ((size_t)n + 1)) slots *= 2;
+    SnapshotLayout l;
+    snapshot_layout(&l, (size_t)n, edges, slots);
+
+    char tmp_path[PATH_LEN + 8];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    int fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate(fd, (off_t)l.end) != 0) {
+        printf("Error: Could not create %s.\n", tmp_path);
+        if (fd >= 0) close(fd);
+        free(dense);
+        return 0;
+    }
+    unsigned char* data = mmap(NULL, l.end, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        printf("Error: Could not map %s.\n", tmp_path);
+        close(fd);
+        unlink(tmp_path);
+        free(dense);
+        return 0;
+    }
+
+    // The file starts zeroed, so IDs and padding need no explicit fill
+    char (*ids)[ID_LEN] = (char (*)[ID_LEN])(data + l.ids);
+    int32_t* id_slots = (int32_t*)(data + l.slots);
+    memset(id_slots, -1, slots * sizeof(int32_t)); // SLOT_EMPTY
+    for (int i = 0; i < g->num_slots; i++) {
+        if (!user_live(g, i)) continue;
+        strcpy(ids[dense[i]], g->user_ids[i]);
+        size_t s = hash_id(g->user_ids[i]) & (slots - 1);
+        while (id_slots[s] != SLOT_EMPTY) s = (s + 1) & (slots - 1);
+        id_slots[s] = dense[i];
+    }
+    write_csr(g, g->out, dense, (uint64_t*)(data + l.out_offsets), (int32_t*)(data + l.out_edges));
+    write_csr(g, g->in, dense, (uint64_t*)(data + l.in_offsets), (int32_t*)(data + l.in_edges));
+    free(dense);
+
+    SnapshotHeader* h = (SnapshotHeader*)data;
+    h->magic = SNAPSHOT_MAGIC;
+    h->version = SNAPSHOT_VERSION;
+    h->id_len = ID_LEN;
+    h->num_users = (uint32_t)n;
+    h->num_edges = edges;
+    h->hash_slots = slots;
+    h->checksum = snapshot_checksum(data, &l);
+    munmap(data, l.end);
+    int ok = fsync(fd) == 0;
+    close(fd);
+    if (!ok || rename(tmp_path, path) != 0) {
+        printf("Error: Could not write %s.\n", path);
+        unlink(tmp_path);
+        return 0;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+    printf("Saved %d users and %llu interactions to %s (%.1f MB) in %.2f s.\n",
+           n, (unsigned long long)edges, path, (double)l.end / (1 << 20), secs);
+    return 1;
+}
+
+// Offsets must climb from 0 to 'edges' and every target must be a user
+const char* check_csr(const uint64_t* offsets, const int32_t* targets, uint32_t users, uint64_t edges) {
+    if (offsets[0] != 0 || offsets[users] != edges) return "bad row offsets";
+    for (uint32_t i = 0; i < users; i++) {
+        if (offsets[i] > offsets[i + 1]) return "bad row offsets";
+    }
+    uint32_t bad = 0;
+    for (uint64_t k = 0; k < edges; k++) bad |= (uint32_t)targets[k] >= users;
+    return bad ? "interaction names a missing user" : NULL;
+}
+
+// Reason the mapped file can't be used, or NULL if it is a sound snapshot
+const char* check_snapshot(const unsigned char* data, size_t size, SnapshotLayout* l) {
+    const SnapshotHeader* h = (const SnapshotHeader*)data;
+    if (size < sizeof(SnapshotHeader) || h->magic != SNAPSHOT_MAGIC) return "not a snapshot";
+    if (h->version != SNAPSHOT_VERSION) return "unsupported version";
+    if (h->id_len != ID_LEN) return "written with a different ID length";
+    if (h->num_edges > size / 8 || h->hash_slots > size / 4 || h->num_users > INT32_MAX / 4) return "truncated";
+    if (h->hash_slots < 2 * ((uint64_t)h->num_users + 1) || (h->hash_slots & (h->hash_slots - 1))) {
+        return "bad ID hash table";
+    }
+    snapshot_layout(l, h->num_users, h->num_edges, h->hash_slots);
+    if (size < l->end) return "truncated";
+    if (size > l->end) return "unexpected data after the last section";
+    if (snapshot_checksum(data, l) != h->checksum) return "checksum mismatch";
+
+    const int32_t* id_slots = (const int32_t*)(data + l->slots);
+    uint64_t used = 0;
+    for (uint64_t s = 0; s < h->hash_slots; s++) {
+        if (id_slots[s] < SLOT_EMPTY || id_slots[s] >= (int32_t)h->num_users) return "bad ID hash table";
+        used += id_slots[s] != SLOT_EMPTY;
+    }
+    if (used != h->num_users) return "bad ID hash table";
+    const char* ids = (const char*)(data + l->ids);
+    for (uint32_t i = 0; i < h->num_users; i++) {
+        if (!memchr(ids + (size_t)i * ID_LEN, '\0', ID_LEN)) return "unterminated user ID";
+    }
+    const char* why = check_csr((const uint64_t*)(data + l->out_offsets), (const int32_t*)(data + l->out_edges),
+                                h->num_users, h->num_edges);
+    if (!why) {
+        why = check_csr((const uint64_t*)(data + l->in_offsets), (const int32_t*)(data + l->in_edges),
+                        h->num_users, h->num_edges);
+    }
+    return why;
+}
+
+// Load into a freshly initialised graph. Rows are not copied: each AdjSet
+// borrows its slice of the mapping until it is first modified.
+int load_snapshot(SocialGraph* g, const char* path) {
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        printf("Error: Could not open %s.\n", path);
+        if (fd >= 0) close(fd);
+        return 0;
+    }
+    size_t size = (size_t)st.st_size;
+    unsigned char* data = size ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (data == MAP_FAILED) {
+        printf("Error: %s is not a valid snapshot (empty or unmappable).\n", path);
+        return 0;
+    }
+    SnapshotLayout l;
+    const char* why = check_snapshot(data, size, &l);
+    if (why) {
+        printf("Error: %s is not a valid snapshot (%s).\n", path, why);
+        munmap(data, size);
+        return 0;
+    }
+
+    const SnapshotHeader* h = (const SnapshotHeader*)data;
+    int n = (int)h->num_users;
+    int capacity = g->capacity;
+    while (capacity < n) capacity *= 2;
+    int* id_slots = malloc(sizeof(int) * h->hash_slots);
+    if (!id_slots || (capacity > g->capacity && !grow_users(g, capacity))) {
+        printf("Error: Out of memory loading %s.\n", path);
+        free(id_slots);
+        munmap(data, size);
+        return 0;
+    }
+    memcpy(g->user_ids, data + l.ids, (size_t)n * ID_LEN);
+    memcpy(id_slots, data + l.slots, sizeof(int) * h->hash_slots);
+    free(g->id_slots);
+    g->id_slots = id_slots;
+    g->slot_count = (int)h->hash_slots;
+    g->slot_used = n;
+
+    const uint64_t* out_offsets = (const uint64_t*)(data + l.out_offsets);
+    const uint64_t* in_offsets = (const uint64_t*)(data + l.in_offsets);
+    int* out_edges = (int*)(data + l.out_edges);
+    int* in_edges = (int*)(data + l.in_edges);
+    for (int i = 0; i < n; i++) {
+        AdjSet* out = &g->out[i];
+        AdjSet* in = &g->in[i];
+        memset(out, 0, sizeof(AdjSet));
+        memset(in, 0, sizeof(AdjSet));
+        out->count = (int)(out_offsets[i + 1] - out_offsets[i]);
+        if (out->count) out->items = out_edges + out_offsets[i];
+        in->count = (int)(in_offsets[i + 1] - in_offsets[i]);
+        if (in->count) in->items = in_edges + in_offsets[i];
+    }
+    memset(g->state, USER_LIVE, (size_t)h->num_users);
+    memset(g->live_bits, 0, sizeof(uint64_t) * ((size_t)g->capacity / 64 + 1));
+    for (int i = 0; i < n; i++) g->live_bits[i / 64] |= 1ULL << (i % 64);
+    g->num_users = n;
+    g->num_slots = n;
+    g->snapshot = data;
+    g->snapshot_size = size;
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ms = (double)(t1.tv_sec - t0.tv_sec) * 1e3 + (double)(t1.tv_nsec - t0.tv_nsec) / 1e6;
+    printf("Loaded %d users and %llu interactions from %s in %.2f ms.\n",
+           n, (unsigned long long)h->num_edges, path, ms);
+    return 1;
+}
+
+// Whether 'path' starts with the snapshot magic (otherwise treat it as an edge list)
+int is_snapshot(const char* path) {
+    uint32_t magic = 0;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+    ssize_t got = read(fd, &magic, sizeof(magic));
+    close(fd);
+    return got == (ssize_t)sizeof(magic) && magic == SNAPSHOT_MAGIC;
+}
+
 // --- Main Interface ---
 
-int main() {
+int main(int argc, char* argv[]) {
     SocialGraph graph;
-    init_graph(&graph);
-
-    // 1. Hardcode Data from Question Image
-    printf("Initializing Network Data...\n");
-    add_interaction(&graph, "U101", "U102");
-    add_interaction(&graph, "U101", "U103");
-    add_interaction(&graph, "U102", "U104");
-    add_interaction(&graph, "U103", "U105");
-    add_interaction(&graph, "U104", "U105");
-    add_interaction(&graph, "U104", "U106");
-    add_interaction(&graph, "U105", "U107");
-    add_interaction(&graph, "U106", "U108");
-
-    int choice;
+    if (!init_graph(&graph)) return 1;
+
+    if (argc > 1) {
+        // Start from a snapshot or edge-list file instead of the sample network
+        int loaded = is_snapshot(argv[1]) ? load_snapshot(&graph, argv[1]) : import_edge_list(&graph, argv[1]);
+        if (!loaded) {
+            free_graph(&graph);
+            return 1;
+        }
+    } else {
+        // 1. Hardcode Data from Question Image
+        printf("Initializing Network Data...\n");
+        add_interaction(&graph, "U101", "U102");
+        add_interaction(&graph, "U101", "U103");
+        add_interaction(&graph, "U102", "U104");
+        add_interaction(&graph, "U103", "U105");
+        add_interaction(&graph, "U104", "U105");
+        add_interaction(&graph, "U104", "U106");
+        add_interaction(&graph, "U105", "U107");
+        add_interaction(&graph, "U106", "U108");
+    }
+
+    int choice, hops, top;
+    char metric;
     char id1[ID_LEN], id2[ID_LEN];
+    char path[PATH_LEN];
+    SocialGraph loaded;
 
     while(1) {
-        printf("\n1. Show Matrix\n2. Query User\n3. Add Interaction\n4. Remove Interaction\n5. Remove User\n6. Exit\nSelect: ");
+        printf("\n1. Show Matrix\n2. Query User\n3. Add Interaction\n4. Remove Interaction\n5. Remove User\n6. Exit\n"
+               "7. Mutual Follows\n8. Common Neighbours\n9. Jaccard Similarity\n10. Both Interact With\n"
+               "11. Users Within K Hops\n12. Shortest Interaction Chain\n13. Reach Size\n14. Import Edge List\n"
+               "15. Save Snapshot\n16. Load Snapshot\n17. Top Influencers\n18. User Centrality\nSelect: ");
         if (scanf("%d", &choice) != 1) break;
 
         switch(choice) {
@@ -209,10 +1983,74 @@ int main() {
                 break;
             case 6:
                 printf("Exiting tool.\n");
+                free_graph(&graph);
                 return 0;
+            case 7:
+                printf("Enter User ID: ");
+                scanf("%s", id1);
+                mutual_follows(&graph, id1);
+                break;
+            case 8:
+                printf("Enter two User IDs: ");
+                scanf("%s %s", id1, id2);
+                common_neighbours(&graph, id1, id2);
+                break;
+            case 9:
+                printf("Enter two User IDs: ");
+                scanf("%s %s", id1, id2);
+                jaccard_similarity(&graph, id1, id2);
+                break;
+            case 10:
+                printf("Enter two User IDs: ");
+                scanf("%s %s", id1, id2);
+                both_interact_with(&graph, id1, id2);
+                break;
+            case 11:
+                printf("Enter User ID and hop limit: ");
+                if (scanf("%s %d", id1, &hops) == 2) k_hop_reach(&graph, id1, hops);
+                break;
+            case 12:
+                printf("Enter From_ID To_ID: ");
+                scanf("%s %s", id1, id2);
+                shortest_chain(&graph, id1, id2);
+                break;
+            case 13:
+                printf("Enter User ID: ");
+                scanf("%s", id1);
+                reach_size(&graph, id1);
+                break;
+            case 14:
+                printf("Enter edge list file (one 'From_ID To_ID' per line): ");
+                if (scanf("%255s", path) == 1) import_edge_list(&graph, path);
+                break;
+            case 15:
+                printf("Enter snapshot file: ");
+                if (scanf("%255s", path) == 1) save_snapshot(&graph, path);
+                break;
+            case 16:
+                printf("Enter snapshot file: ");
+                if (scanf("%255s", path) != 1) break;
+                // Replace the current graph only once the snapshot has loaded
+                if (init_graph(&loaded) && load_snapshot(&loaded, path)) {
+                    free_graph(&graph);
+                    graph = loaded;
+                } else {
+                    free_graph(&loaded);
+                }
+                break;
+            case 17:
+                printf("Enter k and metric (p = PageRank, i = in-degree, o = out-degree): ");
+                if (scanf("%d %c", &top, &metric) == 2) top_influencers(&graph, top, metric);
+                break;
+            case 18:
+                printf("Enter User ID: ");
+                scanf("%s", id1);
+                user_centrality(&graph, id1);
+                break;
             default:
                 printf("Invalid choice.\n");
         }
     }
+    free_graph(&graph);
     return 0;
 }
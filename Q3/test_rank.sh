@@ -0,0 +1,38 @@
+#!/bin/sh
+# PageRank refresh check: after one new interaction into a hub, refreshing
+# the ranks must push the change out in less time than the full computation
+# took. One out of a hub spreads to most users, so there the refresh may give
+# up and recompute, but must not take twice as long as the full computation.
+# Run from the Q3 folder: sh test_rank.sh
+set -e
+
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+gcc -O2 -pthread social_graph.c -o "$dir/social" -lm
+
+# 20000 users, 300000 interactions; one in ten points at hubs U0-U49
+awk 'BEGIN {
+    srand(1);
+    for (i = 0; i < 300000; i++) {
+        v = rand() < 0.1 ? int(rand() * 50) : int(rand() * 20000);
+        printf "U%d U%d\n", int(rand() * 20000), v;
+    }
+}' > "$dir/edges.txt"
+
+check() {
+    name=$1
+    limit=$2
+    printf '17\n1 p\n3\n%s\n17\n1 p\n6\n' "$name" | "$dir/social" "$dir/edges.txt" > "$dir/rank.out"
+    full=$(sed -n 's/.*PageRank computed over .* (\([0-9.]*\) ms).*/\1/p' "$dir/rank.out" | head -n 1)
+    refresh=$(grep -E 'PageRank (computed|refreshed)' "$dir/rank.out" | sed -n '2s/.*(\([0-9.]*\) ms).*/\1/p')
+    if [ -n "$full" ] && [ -n "$refresh" ] && awk "BEGIN { exit !($refresh < $limit * $full) }"; then
+        echo "PASS: $name refreshed in $refresh ms, full computation took $full ms"
+    else
+        echo "FAIL: $name"
+        grep -E 'PageRank (computed|refreshed)' "$dir/rank.out"
+        exit 1
+    fi
+}
+
+check "U777 U14" 1
+check "U14 U777" 2